@@ -0,0 +1,196 @@
+/*
+** animation.c
+**
+** Written by Arda Akgur
+**
+** Keyframed LED matrix animations. Each animation is a sequence of
+** keyframes stored in program memory. A keyframe either shows a fixed
+** colour or redraws whatever is really at the cell. Animations never
+** wait - step_animations() checks each slot once and only sends pixel
+** updates while there is SPI budget left for this call.
+*/
+
+#include <avr/pgmspace.h>
+#include "animation.h"
+#include "game.h"
+#include "ledmatrix.h"
+#include "pixel_colour.h"
+#include "timer0.h"
+
+// bytes sent over SPI by one ledmatrix_update_pixel() call
+#define PIXEL_UPDATE_BYTES 3
+
+// keyframe durations are stored in units of 10ms
+#define KEY_TIME_UNIT 10
+
+// a keyframe with this flag set redraws the real contents of the cell
+#define KEY_CELL 0x01
+
+typedef struct {
+	uint8_t duration;	// 0 marks the end of the sequence
+	PixelColour colour;
+	uint8_t flags;
+} AnimationKey;
+
+static const AnimationKey eat_keys[] PROGMEM = {
+	{6, COLOUR_YELLOW, 0}, {6, COLOUR_BLACK, KEY_CELL},
+	{6, COLOUR_YELLOW, 0}, {0, COLOUR_BLACK, 0}
+};
+
+static const AnimationKey death_keys[] PROGMEM = {
+	{15, COLOUR_RED, 0}, {15, COLOUR_BLACK, 0},
+	{15, COLOUR_RED, 0}, {15, COLOUR_BLACK, 0},
+	{15, COLOUR_RED, 0}, {15, COLOUR_BLACK, 0},
+	{15, COLOUR_RED, 0}, {0, COLOUR_BLACK, 0}
+};
+
+static const AnimationKey super_food_spawn_keys[] PROGMEM = {
+	{8, COLOUR_YELLOW, 0}, {8, COLOUR_BLACK, 0},
+	{8, COLOUR_YELLOW, 0}, {0, COLOUR_BLACK, 0}
+};
+
+// blinks for one second, the super food is removed when it ends
+static const AnimationKey super_food_expire_keys[] PROGMEM = {
+	{10, COLOUR_BLACK, 0}, {10, COLOUR_BLACK, KEY_CELL},
+	{10, COLOUR_BLACK, 0}, {10, COLOUR_BLACK, KEY_CELL},
+	{10, COLOUR_BLACK, 0}, {10, COLOUR_BLACK, KEY_CELL},
+	{10, COLOUR_BLACK, 0}, {10, COLOUR_BLACK, KEY_CELL},
+	{10, COLOUR_BLACK, 0}, {10, COLOUR_BLACK, KEY_CELL},
+	{0, COLOUR_BLACK, 0}
+};
+
+// indexed by AnimationType
+static const AnimationKey* const sequences[] PROGMEM = {
+	eat_keys, death_keys, super_food_spawn_keys, super_food_expire_keys
+};
+
+/* An animation slot. key points at the current keyframe in program
+** memory, or is 0 once the sequence has ended. pending is set when
+** the cell needs to be sent to the display - a slot is only free when
+** it has no keyframe and nothing pending.
+*/
+typedef struct {
+	const AnimationKey* key;
+	uint32_t key_end_time;
+	PosnType posn;
+	PixelColour owner;	// colour of the cell when the animation started
+	PixelColour colour;	// colour to send if not drawing the cell
+	uint8_t draw_cell;
+	uint8_t pending;
+} Animation;
+
+static Animation animations[MAX_ANIMATIONS];
+
+// slot serviced first on the next step, rotated so all slots get budget
+static uint8_t first_slot;
+
+// slot replaced when all slots are busy
+static uint8_t victim_slot;
+
+// cells of replaced animations that still need their real contents
+// sent, which step_animations() does before any slot's update
+static PosnType restore_cells[MAX_ANIMATIONS];
+static uint8_t num_restores;
+
+// helper method
+static void update_display_at_position(PosnType posn, PixelColour colour) {
+	ledmatrix_update_pixel(x_position(posn), y_position(posn), colour);
+}
+
+// sets up the slot to show the keyframe it points to
+static void load_keyframe(Animation* anim, uint32_t now) {
+	uint8_t duration = pgm_read_byte(&anim->key->duration);
+	if (duration == 0 || get_colour_at_position(anim->posn) != anim->owner) {
+		// sequence finished or the cell changed under us - put the
+		// real cell contents back and free the slot once that is sent
+		anim->key = 0;
+		anim->draw_cell = 1;
+	} else {
+		anim->colour = pgm_read_byte(&anim->key->colour);
+		anim->draw_cell = pgm_read_byte(&anim->key->flags) & KEY_CELL;
+		anim->key_end_time = now + (uint32_t)duration * KEY_TIME_UNIT;
+	}
+	anim->pending = 1;
+}
+
+void init_animations(void) {
+	uint8_t i;
+	for (i = 0; i < MAX_ANIMATIONS; i++) {
+		animations[i].key = 0;
+		animations[i].pending = 0;
+	}
+	first_slot = 0;
+	victim_slot = 0;
+	num_restores = 0;
+}
+
+void start_animation(AnimationType type, PosnType posn) {
+	Animation* anim = 0;
+	uint8_t i;
+	// reuse the slot already at this position, otherwise a free one
+	for (i = 0; i < MAX_ANIMATIONS; i++) {
+		if ((animations[i].key || animations[i].pending) && animations[i].posn == posn) {
+			anim = &animations[i];
+			break;
+		}
+		if (!anim && !animations[i].key && !animations[i].pending) {
+			anim = &animations[i];
+		}
+	}
+	if (!anim) {
+		// all busy - replace a slot and have its cell restored within
+		// the budget, unless too many are waiting for that already (the
+		// new animation is dropped then, nothing has been drawn for it)
+		if (num_restores == MAX_ANIMATIONS) {
+			return;
+		}
+		anim = &animations[victim_slot];
+		victim_slot = (victim_slot + 1) % MAX_ANIMATIONS;
+		restore_cells[num_restores++] = anim->posn;
+	}
+	anim->posn = posn;
+	anim->owner = get_colour_at_position(posn);
+	anim->key = (const AnimationKey*)pgm_read_word(&sequences[type]);
+	load_keyframe(anim, get_clock_ticks());
+}
+
+uint8_t is_animation_at(PosnType posn) {
+	uint8_t i;
+	for (i = 0; i < MAX_ANIMATIONS; i++) {
+		if (animations[i].key && animations[i].posn == posn) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void step_animations(void) {
+	uint32_t now = get_clock_ticks();
+	uint8_t budget = ANIMATION_SPI_BUDGET;
+	uint8_t i;
+	// replaced animations' cells first, so a new animation at the same
+	// cell isn't drawn over
+	while (num_restores && budget >= PIXEL_UPDATE_BYTES) {
+		num_restores--;
+		update_display_at_position(restore_cells[num_restores],
+				get_colour_at_position(restore_cells[num_restores]));
+		budget -= PIXEL_UPDATE_BYTES;
+	}
+	for (i = 0; i < MAX_ANIMATIONS; i++) {
+		Animation* anim = &animations[(first_slot + i) % MAX_ANIMATIONS];
+		if (anim->key && now >= anim->key_end_time) {
+			anim->key++;
+			load_keyframe(anim, now);
+		}
+		if (anim->pending && budget >= PIXEL_UPDATE_BYTES) {
+			if (anim->draw_cell) {
+				update_display_at_position(anim->posn, get_colour_at_position(anim->posn));
+			} else {
+				update_display_at_position(anim->posn, anim->colour);
+			}
+			anim->pending = 0;
+			budget -= PIXEL_UPDATE_BYTES;
+		}
+	}
+	first_slot = (first_slot + 1) % MAX_ANIMATIONS;
+}
@@ -0,0 +1,71 @@
+/*
+** animation.h
+**
+** Written by Arda Akgur
+**
+** Non-blocking keyframed animations on the LED matrix. Animations
+** are started by game events and advanced by step_animations(),
+** which is called from the main loop. Each call costs a fixed amount
+** of work and sends at most ANIMATION_SPI_BUDGET bytes over SPI, so
+** game logic never waits on an animation.
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef ANIMATION_H_
+#define ANIMATION_H_
+
+#include <inttypes.h>
+#include "position.h"
+
+/* Number of animations that can run at the same time. Starting an
+** animation when all slots are busy replaces the oldest one, whose cell
+** is then redrawn by step_animations() within its budget. If that many
+** replaced cells are already waiting to be redrawn the new animation
+** isn't started.
+*/
+#define MAX_ANIMATIONS 4
+
+/* Maximum number of SPI bytes step_animations() may send per call.
+** A pixel update costs 3 bytes.
+*/
+#define ANIMATION_SPI_BUDGET 6
+
+typedef enum {
+	ANIM_EAT,
+	ANIM_DEATH,
+	ANIM_SUPER_FOOD_SPAWN,
+	ANIM_SUPER_FOOD_EXPIRE
+} AnimationType;
+
+/* init_animations()
+**
+** Stop all running animations. Nothing is redrawn - this should be
+** called when the display is being cleared anyway.
+*/
+void init_animations(void);
+
+/* start_animation(type, position)
+**
+** Start an animation at the given board position. Any animation
+** already running at that position is replaced. The animation ends
+** early (and the cell is redrawn) if whatever occupied the cell when
+** the animation started is no longer there.
+*/
+void start_animation(AnimationType type, PosnType posn);
+
+/* is_animation_at(position)
+**
+** Returns 1 if an animation is running at the given position,
+** 0 otherwise.
+*/
+uint8_t is_animation_at(PosnType posn);
+
+/* step_animations()
+**
+** Advance all running animations to the current time and send any
+** pixel changes that fit within the SPI budget. Changes that don't
+** fit are sent on a later call.
+*/
+void step_animations(void);
+
+#endif
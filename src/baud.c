@@ -0,0 +1,111 @@
+/*
+** baud.c
+**
+** Written by Arda Akgur
+**
+** Runtime baud rate changes. All waiting is done by polling from
+** step_baud() so the game keeps running while the old output drains.
+*/
+
+#include <stdio.h>
+#include <avr/pgmspace.h>
+#include "baud.h"
+#include "serialio.h"
+#include "terminal_view.h"
+#include "timer0.h"
+
+// Rates the host can ask for, by index
+static const uint32_t baud_rates[] PROGMEM = {
+	19200, 57600, 76800, 125000, 250000
+};
+#define NUM_BAUD_RATES (sizeof(baud_rates) / sizeof(baud_rates[0]))
+
+// Throughput check - a complete redraw of the board must go out within
+// one terminal refresh at every rate from 57600 up. A byte is 10 bits
+// on the wire (start, 8 data, stop), and each rate is checked as if it
+// ran MAX_BAUD_ERROR slow, the worst set_serial_baud() accepts (at 8MHz
+// 57600 actually runs at 58824, 76800 at 76923, the others exactly).
+//
+// 19200 is left out on purpose: it is the rate at reset, so the host
+// can always reach the game, but a full redraw (850 bytes) takes about
+// 443ms there, so it spans three refreshes. The frames started in the
+// meantime are skipped and the next one sends everything that changed,
+// so the view keeps up with the game, just less often. Switch to a
+// faster rate to get every refresh.
+#define SLOWEST_BAUD(rate) ((uint32_t)(rate) * (1000 - MAX_BAUD_ERROR) / 1000)
+#define FRAME_FITS(rate) ((uint32_t)TERMINAL_FULL_FRAME_BYTES * 10 * 1000 \
+		<= SLOWEST_BAUD(rate) * TERMINAL_REFRESH_TIME)
+_Static_assert(FRAME_FITS(57600), "full terminal frame doesn't fit in a refresh at 57600 baud");
+_Static_assert(FRAME_FITS(76800), "full terminal frame doesn't fit in a refresh at 76800 baud");
+_Static_assert(FRAME_FITS(125000), "full terminal frame doesn't fit in a refresh at 125000 baud");
+_Static_assert(FRAME_FITS(250000), "full terminal frame doesn't fit in a refresh at 250000 baud");
+_Static_assert(!FRAME_FITS(19200), "19200 baud now fits a full frame, update the comment above");
+
+typedef enum {
+	BAUD_IDLE,			// no change in progress
+	BAUD_WANT_INDEX,	// 'b' received, waiting for the rate index
+	BAUD_DRAINING,		// reply sent, waiting for output to finish
+	BAUD_CONFIRMING,	// switched, waiting for the host's 'k'
+	BAUD_REVERTING		// not confirmed, waiting for output to finish
+} BaudState;
+
+static uint8_t state = BAUD_IDLE;
+static long new_baud;
+static long old_baud;
+static uint32_t confirm_deadline;
+
+uint8_t handle_baud_input(char c) {
+	switch (state) {
+		case BAUD_IDLE:
+			if (c == 'b' || c == 'B') {
+				state = BAUD_WANT_INDEX;
+				return 1;
+			}
+			break;
+		case BAUD_WANT_INDEX:
+			state = BAUD_IDLE;
+			if (c >= '0' && c < '0' + NUM_BAUD_RATES) {
+				new_baud = pgm_read_dword(&baud_rates[c - '0']);
+				printf_P(PSTR("BAUD %ld\n"), new_baud);
+				state = BAUD_DRAINING;
+				return 1;
+			}
+			break;
+		case BAUD_CONFIRMING:
+			if (c == 'k' || c == 'K') {
+				state = BAUD_IDLE;
+				printf_P(PSTR("BAUD OK\n"));
+				return 1;
+			}
+			break;
+		default:
+			break;
+	}
+	return 0;
+}
+
+void step_baud(void) {
+	if (state == BAUD_DRAINING && serial_output_idle()) {
+		old_baud = get_serial_baud();
+		set_serial_baud(new_baud);
+		confirm_deadline = get_clock_ticks() + BAUD_CONFIRM_TIME;
+		state = BAUD_CONFIRMING;
+		// the terminal may have been cleared or garbled, start again
+		if (is_terminal_view_shown()) {
+			init_terminal_view();
+		}
+	} else if (state == BAUD_CONFIRMING && get_clock_ticks() >= confirm_deadline) {
+		// let what's already queued for the new rate go first
+		state = BAUD_REVERTING;
+	} else if (state == BAUD_REVERTING && serial_output_idle()) {
+		set_serial_baud(old_baud);
+		state = BAUD_IDLE;
+		if (is_terminal_view_shown()) {
+			init_terminal_view();
+		}
+	}
+}
+
+uint8_t is_baud_switching(void) {
+	return state == BAUD_DRAINING || state == BAUD_REVERTING;
+}
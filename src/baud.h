@@ -0,0 +1,54 @@
+/*
+** baud.h
+**
+** Written by Arda Akgur
+**
+** Changing the serial baud rate while the game runs, at the host's
+** request. The host sends 'b' followed by the index of a rate:
+**   0 - 19200 (the rate at reset, too slow for a full redraw every
+**       refresh, see baud.c)
+**   1 - 57600
+**   2 - 76800
+**   3 - 125000
+**   4 - 250000
+** The game replies "BAUD <rate>" at the old rate, waits for that to be
+** sent, then switches. The host then has BAUD_CONFIRM_TIME ms to send
+** 'k' at the new rate (answered with "BAUD OK"), otherwise the game
+** goes back to the old rate, so a rate the host can't manage doesn't
+** lose the link.
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef BAUD_H_
+#define BAUD_H_
+
+#include <inttypes.h>
+
+// Time the host has to confirm a new rate, in milliseconds
+#define BAUD_CONFIRM_TIME 2000
+
+/* handle_baud_input(c)
+**
+** Pass a serial command character to the rate change. Returns 1 if it
+** was part of a rate change request, 0 if it should be handled as
+** usual.
+*/
+uint8_t handle_baud_input(char c);
+
+/* step_baud()
+**
+** Carry out a requested rate change once the reply has been sent, and
+** go back to the old rate if the host doesn't confirm in time. Call
+** from the main loop. Never waits.
+*/
+void step_baud(void);
+
+/* is_baud_switching()
+**
+** Returns 1 while waiting for output to finish before switching rate
+** (or switching back).
+** Nothing else should be sent until this returns 0.
+*/
+uint8_t is_baud_switching(void);
+
+#endif
@@ -0,0 +1,44 @@
+/*
+** boot_profile.c
+**
+** Written by Arda Akgur
+**
+** Timer 1 runs from the 8MHz clock divided by 64, so it counts every
+** 8us and overflows after about 524ms - a stage that finishes after
+** that is just recorded as too long.
+*/
+
+#include <avr/io.h>
+#include "boot_profile.h"
+
+// times in timer 1 counts, 0 for stages not marked
+static uint16_t stage_times[NUM_BOOT_STAGES];
+
+// set once BOOT_PLAYING is marked
+static uint8_t finished;
+
+// Runs in the .init3 section of the startup code, straight after reset
+// and before RAM is cleared, so it can't use variables or return.
+void start_boot_timer(void) __attribute__((naked, used, section(".init3")));
+void start_boot_timer(void) {
+	TCCR1B = (1<<CS11)|(1<<CS10);
+}
+
+void mark_boot_stage(BootStage stage) {
+	if (finished) {
+		return;
+	}
+	if (TIFR1 & (1<<TOV1)) {
+		stage_times[stage] = 0xFFFF;
+	} else {
+		stage_times[stage] = TCNT1;
+	}
+	if (stage == BOOT_PLAYING) {
+		TCCR1B = 0;
+		finished = 1;
+	}
+}
+
+uint32_t get_boot_stage_time(BootStage stage) {
+	return (uint32_t)stage_times[stage] * BOOT_TIME_UNIT;
+}
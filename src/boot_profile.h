@@ -0,0 +1,48 @@
+/*
+** boot_profile.h
+**
+** Written by Arda Akgur
+**
+** Timing of the boot stages. Timer 1 is started before any other code
+** runs (even before RAM is set up) and each stage is marked with the
+** time since reset as the board starts up. Timer 1 is stopped once the
+** game is playable, the times can then be shown with the boot console
+** command.
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef BOOT_PROFILE_H_
+#define BOOT_PROFILE_H_
+
+#include <inttypes.h>
+
+// Microseconds per timer 1 count, and the longest time that can be
+// measured (about half a second)
+#define BOOT_TIME_UNIT 8
+#define BOOT_TIME_LIMIT (0xFFFFUL * BOOT_TIME_UNIT)
+
+// Boot stages, in the order they finish
+typedef enum {
+	BOOT_MAIN,			// main() reached
+	BOOT_HARDWARE,		// devices set up and interrupts on
+	BOOT_JOURNAL,		// EEPROM journal scanned for a saved game
+	BOOT_SPLASH,		// splash screen done (or skipped)
+	BOOT_PLAYING,		// board drawn and the first move can be made
+	NUM_BOOT_STAGES
+} BootStage;
+
+/* mark_boot_stage(stage)
+**
+** Note the time the given stage finished. Marking BOOT_PLAYING stops
+** the timer - later marks are ignored.
+*/
+void mark_boot_stage(BootStage stage);
+
+/* get_boot_stage_time(stage)
+**
+** Returns the time (us) from reset to the end of the given stage, 0 if
+** it wasn't marked, or BOOT_TIME_LIMIT if it took longer than that.
+*/
+uint32_t get_boot_stage_time(BootStage stage);
+
+#endif
@@ -4,7 +4,9 @@
  * Author: Peter Sutton
  *
  * We assume four push buttons (B0 to B3) are connected to pins B0 to B3. We configure
- * pin change interrupts on these pins.
+ * pin change interrupts on these pins. Button pushes are added to the
+ * input event queue (see input.h) as directions:
+ * B0 right, B1 down, B2 up, B3 left.
  */ 
 
 
@@ -19,18 +21,9 @@
  */
 void init_button_interrupts(void);
 
-/* Empty the button press queue
+/* Return the buttons being held down right now - bit n is set if
+ * button Bn is down.
  */
-void empty_button_queue(void);
+uint8_t read_buttons(void);
 
-/* Return the last button pushed (0 to 3) or -1 if there are no
- * button pushes to return. (A small queue of button pushes is
- * kept. This function should be called frequently enough to
- * ensure the queue does not overflow. Excess button pushes are
- * discarded.)
- */
-
-int8_t button_pushed(void);
-
-
-#endif /* BUTTONS_H_ */
\ No newline at end of file
+#endif /* BUTTONS_H_ */
@@ -0,0 +1,418 @@
+/*
+** channel.c
+**
+** Written by Arda Akgur
+**
+** Channel queues, the transmit scheduler and frame encoding. Each
+** queue is a single producer, single consumer ring: channel_write()
+** (main program only) moves the head and the transmit interrupt moves
+** the tail. Frames are COBS encoded a byte at a time as the UART asks
+** for them, straight from the queue - nothing is copied. The tail is
+** only moved past a frame's data once the whole frame has been sent.
+*/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#include "channel.h"
+#include "serialio.h"
+
+// Queue sizes, each a power of two (one byte of each is never used)
+#define TERMINAL_QUEUE_SIZE 128
+#define TELEMETRY_QUEUE_SIZE 64
+#define LOG_QUEUE_SIZE 64
+#define RPC_QUEUE_SIZE 64
+
+// Longest log line, not counting the \n added to it
+#define LOG_LINE_SIZE 40
+
+// tx_channel when no frame is being sent
+#define NO_FRAME 0xFF
+
+static volatile char terminal_queue[TERMINAL_QUEUE_SIZE];
+static volatile char telemetry_queue[TELEMETRY_QUEUE_SIZE];
+static volatile char log_queue[LOG_QUEUE_SIZE];
+static volatile char rpc_queue[RPC_QUEUE_SIZE];
+
+typedef struct {
+	volatile char* buffer;
+	uint8_t mask;
+	volatile uint8_t head;
+	volatile uint8_t tail;
+	int8_t deficit;		// bytes it may still send this round
+	ChannelStats stats;
+} ChannelQueue;
+
+// indexed by Channel
+static ChannelQueue queues[NUM_CHANNELS] = {
+	{terminal_queue, TERMINAL_QUEUE_SIZE - 1},
+	{telemetry_queue, TELEMETRY_QUEUE_SIZE - 1},
+	{log_queue, LOG_QUEUE_SIZE - 1},
+	{rpc_queue, RPC_QUEUE_SIZE - 1}
+};
+
+// Channels from highest to lowest priority
+static const uint8_t priority_order[NUM_CHANNELS] PROGMEM = {
+	CHANNEL_RPC, CHANNEL_TERMINAL, CHANNEL_TELEMETRY, CHANNEL_LOG
+};
+
+// Bytes each channel may send per round, indexed by Channel. When all
+// of them are busy the terminal gets about 45% of the link, telemetry
+// 30%, RPC 15% and the log 10%.
+static const uint8_t quantum[NUM_CHANNELS] PROGMEM = {96, 64, 24, 32};
+
+static uint8_t framed;
+
+// framing as last asked for, made current once output has drained
+static uint8_t framing_wanted;
+
+// stdout when framing is off, and the stream that replaces it
+static FILE* serial_stdout;
+static int channel_put_char(char c, FILE* stream);
+static FILE channel_stream = FDEV_SETUP_STREAM(channel_put_char, NULL, _FDEV_SETUP_WRITE);
+
+// Frame being sent (transmit interrupt only). Frame data is the
+// channel id then tx_length - 1 bytes from the queue. tx_pos is the
+// next data byte to send and tx_block_end the position of the 0 (or
+// the end of the frame) that ends the current COBS block.
+static uint8_t tx_channel = NO_FRAME;
+static uint8_t tx_length;
+static uint8_t tx_pos;
+static uint8_t tx_block_end;
+
+// Frame being received (receive interrupt only). rx_block_left is the
+// number of data bytes left in the current COBS block, 0 if the next
+// byte is a code. rx_zero_pending is set if the block ended with a 0
+// that goes in before the next block.
+static uint8_t rx_frame[RPC_REQUEST_SIZE + 1];
+static uint8_t rx_length;
+static uint8_t rx_block_left;
+static uint8_t rx_zero_pending;
+static uint8_t rx_bad;
+
+// The RPC request waiting to be read. rpc_ready is set by the receive
+// interrupt and cleared once the request has been copied out.
+static uint8_t rpc_request[RPC_REQUEST_SIZE];
+static uint8_t rpc_length;
+static volatile uint8_t rpc_ready;
+
+static uint8_t queued(ChannelQueue* q) {
+	return (q->head - q->tail) & q->mask;
+}
+
+// puts what fits of data (in flash if from_flash is set, in which case
+// it ends at a 0 rather than after length bytes) into the queue
+static uint8_t queue_write(ChannelQueue* q, const char* data, uint8_t length, uint8_t from_flash) {
+	uint8_t head = q->head;
+	uint8_t written = 0;
+	char c;
+	while (written < length && ((head + 1) & q->mask) != q->tail) {
+		c = from_flash ? pgm_read_byte(data + written) : data[written];
+		if (from_flash && !c) {
+			break;
+		}
+		q->buffer[head] = c;
+		head = (head + 1) & q->mask;
+		written++;
+	}
+	// the data is in place before the interrupt can see it
+	q->head = head;
+	q->stats.bytes += written;
+	if (written) {
+		start_serial_output();
+	}
+	return written;
+}
+
+// byte i of the frame being sent
+static uint8_t frame_byte(uint8_t i) {
+	ChannelQueue* q = &queues[tx_channel];
+	if (i == 0) {
+		return tx_channel + 1;
+	}
+	return q->buffer[(q->tail + i - 1) & q->mask];
+}
+
+static uint8_t find_block_end(void) {
+	uint8_t i = tx_pos;
+	while (i < tx_length && frame_byte(i) != 0) {
+		i++;
+	}
+	return i;
+}
+
+// picks the next channel to send a frame from, returns 0 if none has
+// anything to send
+static uint8_t start_frame(void) {
+	ChannelQueue* q;
+	uint8_t i, channel, length, waiting;
+	
+	while (1) {
+		waiting = 0;
+		for (i = 0; i < NUM_CHANNELS; i++) {
+			channel = pgm_read_byte(&priority_order[i]);
+			q = &queues[channel];
+			if (queued(q)) {
+				waiting = 1;
+				if (q->deficit > 0) {
+					length = queued(q);
+					if (length > CHANNEL_FRAME_PAYLOAD) {
+						length = CHANNEL_FRAME_PAYLOAD;
+					}
+					q->deficit -= length;
+					tx_channel = channel;
+					tx_length = length + 1;
+					tx_pos = 0;
+					return 1;
+				}
+			}
+		}
+		if (!waiting) {
+			return 0;
+		}
+		// everything waiting has used its share - start a new round.
+		// Idle channels don't build up credit. (Only a channel that
+		// overspent is topped up, so the sum stays within an int8_t.)
+		for (channel = 0; channel < NUM_CHANNELS; channel++) {
+			q = &queues[channel];
+			if (q->deficit <= 0) {
+				q->deficit += pgm_read_byte(&quantum[channel]);
+			} else {
+				q->deficit = pgm_read_byte(&quantum[channel]);
+			}
+		}
+	}
+}
+
+// output source for the transmit interrupt - the next byte of the
+// encoded frames, or -1 if there's nothing to send
+static int16_t next_frame_byte(void) {
+	ChannelQueue* q;
+	if (tx_channel == NO_FRAME) {
+		if (!start_frame()) {
+			return -1;
+		}
+		tx_block_end = find_block_end();
+		return tx_block_end - tx_pos + 1;
+	}
+	if (tx_pos < tx_block_end) {
+		return frame_byte(tx_pos++);
+	}
+	if (tx_block_end == tx_length) {
+		// end of frame - free its data and send the delimiter
+		q = &queues[tx_channel];
+		q->tail = (q->tail + tx_length - 1) & q->mask;
+		q->stats.frames++;
+		tx_channel = NO_FRAME;
+		return 0;
+	}
+	// the 0 that ended this block is replaced by the next code
+	tx_pos++;
+	tx_block_end = find_block_end();
+	return tx_block_end - tx_pos + 1;
+}
+
+static void add_rx_byte(uint8_t b) {
+	if (rx_length < sizeof(rx_frame)) {
+		rx_frame[rx_length++] = b;
+	} else {
+		rx_bad = 1;
+	}
+}
+
+static void deliver_frame(void) {
+	uint8_t i;
+	switch (rx_frame[0] - 1) {
+		case CHANNEL_TERMINAL:
+			for (i = 1; i < rx_length; i++) {
+				serial_receive_char(rx_frame[i]);
+			}
+			break;
+		case CHANNEL_RPC:
+			if (!rpc_ready) {
+				for (i = 1; i < rx_length; i++) {
+					rpc_request[i - 1] = rx_frame[i];
+				}
+				rpc_length = rx_length - 1;
+				rpc_ready = 1;
+			}
+			break;
+	}
+}
+
+// raw input handler while framing is on
+static void receive_byte(char c) {
+	uint8_t b = c;
+	if (b == 0) {
+		// end of frame - ignore it if it was cut short or too long
+		if (!rx_bad && rx_block_left == 0 && rx_length > 0) {
+			deliver_frame();
+		}
+		rx_length = 0;
+		rx_block_left = 0;
+		rx_zero_pending = 0;
+		rx_bad = 0;
+	} else if (rx_block_left == 0) {
+		// a code byte, which also means the last block ended in a 0
+		// (unless it was a full 254 byte block)
+		if (rx_zero_pending) {
+			add_rx_byte(0);
+		}
+		rx_block_left = b - 1;
+		rx_zero_pending = (b != 0xFF);
+	} else {
+		add_rx_byte(b);
+		rx_block_left--;
+	}
+}
+
+static int channel_put_char(char c, FILE* stream) {
+	if (c == '\n') {
+		channel_put_char('\r', stream);
+	}
+	// wait for room, unless interrupts are off and there never will be
+	while (!queue_write(&queues[CHANNEL_TERMINAL], &c, 1, 0)) {
+		if (bit_is_clear(SREG, SREG_I)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void init_channels(void) {
+	framed = 0;
+	framing_wanted = 0;
+	serial_stdout = stdout;
+	set_serial_output_source(next_frame_byte);
+}
+
+void set_channels_framed(uint8_t on) {
+	framing_wanted = on;
+}
+
+uint8_t step_channels(void) {
+	// let what's queued go out the way it was meant to first
+	if (framing_wanted == framed || !serial_output_idle()) {
+		return 0;
+	}
+	framed = framing_wanted;
+	if (framed) {
+		rx_length = 0;
+		rx_block_left = 0;
+		rx_zero_pending = 0;
+		rx_bad = 0;
+		stdout = &channel_stream;
+		set_serial_raw_input_handler(receive_byte);
+	} else {
+		stdout = serial_stdout;
+		set_serial_raw_input_handler(0);
+	}
+	return 1;
+}
+
+uint8_t is_channel_switching(void) {
+	return framing_wanted != framed;
+}
+
+uint8_t are_channels_framed(void) {
+	return framed;
+}
+
+uint8_t channel_write(uint8_t channel, const char* data, uint8_t length) {
+	ChannelQueue* q = &queues[channel];
+	uint8_t written;
+	if (!framed) {
+		if (channel == CHANNEL_LOG) {
+			return length;
+		}
+		written = serial_write(data, length);
+		q->stats.bytes += written;
+	} else {
+		written = queue_write(q, data, length, 0);
+	}
+	if (written < length) {
+		q->stats.dropped += length - written;
+	}
+	return written;
+}
+
+uint8_t channel_write_P(uint8_t channel, const char* data) {
+	ChannelQueue* q = &queues[channel];
+	uint8_t written;
+	if (!framed) {
+		if (channel == CHANNEL_LOG) {
+			return strlen_P(data);
+		}
+		written = serial_write_P(data);
+		q->stats.bytes += written;
+	} else {
+		written = queue_write(q, data, 0xFF, 1);
+	}
+	q->stats.dropped += strlen_P(data + written);
+	return written;
+}
+
+uint8_t channel_space(uint8_t channel) {
+	ChannelQueue* q = &queues[channel];
+	// hold new output back so the old can drain
+	if (framing_wanted != framed) {
+		return 0;
+	}
+	if (!framed) {
+		return channel == CHANNEL_LOG ? 0xFF : serial_output_space();
+	}
+	return q->mask - queued(q);
+}
+
+uint32_t get_channel_output_count(uint8_t channel) {
+	if (!framed && channel == CHANNEL_TERMINAL) {
+		return get_serial_output_count();
+	}
+	return queues[channel].stats.bytes;
+}
+
+void log_P(const char* format, ...) {
+	char line[LOG_LINE_SIZE + 2];
+	va_list args;
+	int length;
+	
+	// don't bother formatting what would be thrown away
+	if (!framed) {
+		return;
+	}
+	va_start(args, format);
+	length = vsnprintf_P(line, LOG_LINE_SIZE + 1, format, args);
+	va_end(args);
+	if (length > LOG_LINE_SIZE) {
+		length = LOG_LINE_SIZE;
+	}
+	line[length++] = '\n';
+	// a whole line or nothing
+	if (channel_space(CHANNEL_LOG) < length) {
+		queues[CHANNEL_LOG].stats.dropped += length;
+		return;
+	}
+	channel_write(CHANNEL_LOG, line, length);
+}
+
+uint8_t get_rpc_request(uint8_t* buffer) {
+	uint8_t i, length;
+	if (!rpc_ready) {
+		return 0;
+	}
+	length = rpc_length;
+	for (i = 0; i < length; i++) {
+		buffer[i] = rpc_request[i];
+	}
+	rpc_ready = 0;
+	return length;
+}
+
+void get_channel_stats(uint8_t channel, ChannelStats* stats) {
+	// frames is changed by the transmit interrupt
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		*stats = queues[channel].stats;
+	}
+}
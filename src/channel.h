@@ -0,0 +1,140 @@
+/*
+** channel.h
+**
+** Written by Arda Akgur
+**
+** Logical channels over the serial port. Normally everything is sent
+** as it is (the terminal view, or telemetry, straight to the port) and
+** log output is thrown away. With framing turned on, each channel has
+** its own queue and the transmit interrupt sends them as frames:
+**   COBS(channel id, up to CHANNEL_FRAME_PAYLOAD bytes), 0x00
+** where the channel id is the Channel value plus 1. COBS encoding
+** removes every 0x00 from the frame, so 0x00 always marks a frame end
+** and a host that starts listening part way through can pick up at
+** the next frame. tools/chanmux splits the channels back out.
+**
+** Channels are scheduled by priority (RPC, terminal, telemetry, log),
+** but each can only send its share of bytes per round, so a busy
+** channel can't starve the others. Received bytes must be framed the
+** same way. Terminal channel frames are handled like typed characters.
+** RPC channel frames are requests, read with get_rpc_request().
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef CHANNEL_H_
+#define CHANNEL_H_
+
+#include <inttypes.h>
+
+typedef enum {
+	CHANNEL_TERMINAL,
+	CHANNEL_TELEMETRY,
+	CHANNEL_LOG,
+	CHANNEL_RPC,
+	NUM_CHANNELS
+} Channel;
+
+// Most bytes of channel data in one frame. Short frames keep a low
+// priority channel from holding up a high priority one for long.
+#define CHANNEL_FRAME_PAYLOAD 32
+
+// Longest RPC request that can be received
+#define RPC_REQUEST_SIZE CHANNEL_FRAME_PAYLOAD
+
+typedef struct {
+	uint32_t bytes;		// accepted by channel_write()
+	uint16_t dropped;	// refused because the queue was full
+	uint16_t frames;	// frames sent
+} ChannelStats;
+
+/* init_channels()
+**
+** Set up the channels with framing off. Call after
+** init_serial_stdio().
+*/
+void init_channels(void);
+
+/* set_channels_framed(on)
+**
+** Ask for framing to be turned on (1) or off (0). The change is made
+** by step_channels() once anything already queued has been sent.
+** While framing is on, stdout goes to the terminal channel.
+*/
+void set_channels_framed(uint8_t on);
+
+/* step_channels()
+**
+** Make a requested framing change if the serial output has drained.
+** Returns 1 if the change was made on this call, when the terminal
+** view should be redrawn - with init_terminal_view(), which doesn't
+** wait either (anything sent through stdout in framed mode waits for
+** room in the terminal channel). Call from the main loop. Never waits.
+*/
+uint8_t step_channels(void);
+
+/* is_channel_switching()
+**
+** Returns 1 while a framing change is waiting for output to drain.
+** Nothing else should be sent until this returns 0 - channel_space()
+** is 0 until then.
+*/
+uint8_t is_channel_switching(void);
+
+/* are_channels_framed()
+**
+** Returns 1 if framing is on, 0 otherwise.
+*/
+uint8_t are_channels_framed(void);
+
+/* channel_write(channel, data, length)
+**
+** Queue up to length bytes for the channel without waiting. Returns
+** the number of bytes accepted. With framing off, log data is thrown
+** away (but counted as accepted) and everything else goes straight to
+** the serial port.
+*/
+uint8_t channel_write(uint8_t channel, const char* data, uint8_t length);
+
+/* channel_write_P(channel, data)
+**
+** As channel_write(), for a string in program memory.
+*/
+uint8_t channel_write_P(uint8_t channel, const char* data);
+
+/* channel_space(channel)
+**
+** Returns the number of bytes channel_write() can take right now.
+*/
+uint8_t channel_space(uint8_t channel);
+
+/* get_channel_output_count(channel)
+**
+** Returns the number of bytes accepted for the channel so far. With
+** framing off the terminal has the serial port to itself, so for the
+** terminal channel this is everything sent to the port.
+*/
+uint32_t get_channel_output_count(uint8_t channel);
+
+/* log_P(format, ...)
+**
+** printf-style output (format in program memory) to the log channel,
+** cut short at 40 characters. Dropped if the log queue is full.
+*/
+void log_P(const char* format, ...);
+
+/* get_rpc_request(buffer)
+**
+** If an RPC request has arrived, copy it into buffer (which must hold
+** RPC_REQUEST_SIZE bytes) and return its length, otherwise return 0.
+** Only one request is held at a time - any more that arrive before it
+** is read are dropped.
+*/
+uint8_t get_rpc_request(uint8_t* buffer);
+
+/* get_channel_stats(channel, stats)
+**
+** Copy the counters for the channel into *stats.
+*/
+void get_channel_stats(uint8_t channel, ChannelStats* stats);
+
+#endif
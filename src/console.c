@@ -0,0 +1,686 @@
+/*
+** console.c
+**
+** Written by Arda Akgur
+**
+** The serial command console. Commands are looked up in a table kept
+** in program memory and run a step at a time: the handler is called
+** with the step number, writes at most one line of output and returns
+** 1 while it has more to do. The step number only moves on once a line
+** has been written, so a handler with nothing to say yet (bench) is
+** just called again on the next pass.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "console.h"
+#include "channel.h"
+#include "emit.h"
+#include "terminalio.h"
+#include "terminal_view.h"
+#include "game.h"
+#include "snake.h"
+#include "food.h"
+#include "rat.h"
+#include "superFood.h"
+#include "tron.h"
+#include "score.h"
+#include "telemetry.h"
+#include "input.h"
+#include "serialio.h"
+#include "timer0.h"
+#include "eeprom_writer.h"
+#include "journal.h"
+#include "game_record.h"
+#include "boot_profile.h"
+#include "state_hash.h"
+#include "replay.h"
+
+// Channel space needed to send a line of output. On the terminal that
+// is a cursor move, the colour, the text and clearing the rest of the
+// row, over RPC the id, the text and \n, plus the empty line that may
+// follow it to end the response.
+#define TERMINAL_LINE_SPACE (TERMINAL_MOVE_BYTES + TERMINAL_COLOUR_BYTES \
+		+ CONSOLE_LINE_SIZE + 3)
+#define RPC_LINE_SPACE (CONSOLE_LINE_SIZE + 4)
+
+// How long bench counts main loop passes for, in milliseconds
+#define BENCH_TIME 1000
+
+// Game speed limits for the speed command, in hundredths
+#define MIN_SPEED 10
+#define MAX_SPEED 300
+
+// A command handler. It is given the step number (0 first) and the
+// rest of the command line, writes a line of output to out (or leaves
+// it empty) and returns 1 if it should be called again.
+typedef uint8_t (*CommandHandler)(uint8_t step, char* args, char* out);
+
+typedef struct {
+	char usage[20];		// the command name then its arguments
+	CommandHandler run;
+} ConsoleCommand;
+
+static uint8_t run_help(uint8_t step, char* args, char* out);
+static uint8_t run_stats(uint8_t step, char* args, char* out);
+static uint8_t run_state(uint8_t step, char* args, char* out);
+static uint8_t run_speed(uint8_t step, char* args, char* out);
+static uint8_t run_timing(uint8_t step, char* args, char* out);
+static uint8_t run_games(uint8_t step, char* args, char* out);
+static uint8_t run_boot(uint8_t step, char* args, char* out);
+static uint8_t run_bench(uint8_t step, char* args, char* out);
+static uint8_t run_replay(uint8_t step, char* args, char* out);
+static uint8_t run_ping(uint8_t step, char* args, char* out);
+
+static const ConsoleCommand commands[] PROGMEM = {
+	{"help", run_help},
+	{"stats", run_stats},
+	{"state", run_state},
+	{"speed [x.xx]", run_speed},
+	{"timing [name ms]", run_timing},
+	{"games", run_games},
+	{"boot", run_boot},
+	{"bench", run_bench},
+	{"replay [speed]", run_replay},
+	{"ping", run_ping}
+};
+#define NUM_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+// Names of the main loop timings, indexed by GameTiming
+static const char timing_names[NUM_TIMINGS][8] PROGMEM = {
+	"move", "rat", "sfcycle", "sflife", "refresh"
+};
+
+// Short channel names, indexed by Channel
+static const char channel_names[NUM_CHANNELS][5] PROGMEM = {
+	"term", "tel", "log", "rpc"
+};
+
+// Boot stage names, indexed by BootStage
+static const char boot_stage_names[NUM_BOOT_STAGES][9] PROGMEM = {
+	"main", "hardware", "journal", "splash", "playing"
+};
+
+// How games ended, indexed by DeathCause
+static const char death_names[][6] PROGMEM = {
+	"self", "tron", "other", "none"
+};
+
+// Where the running command came from - its output goes back there
+typedef enum {FROM_TERMINAL, FROM_RPC} CommandSource;
+
+// The command line being typed on the terminal. typing is set by ':'
+// and cleared by Enter, which sets input_ready if there is a command
+// to run. input_changed is set when the line on screen is out of date.
+static char input[CONSOLE_INPUT_SIZE + 1];
+static uint8_t input_length;
+static uint8_t typing;
+static uint8_t input_ready;
+static uint8_t input_changed;
+
+// The running command, handler is 0 if there isn't one. The command
+// line is copied here so a new one can be typed while it runs.
+static CommandHandler handler;
+static char command_line[CONSOLE_INPUT_SIZE + 1];
+static char* command_args;
+static uint8_t command_step;
+static uint8_t command_source;
+static uint8_t rpc_id;
+
+// Terminal output row for the next line (0 is the first row below the
+// command line), rows written since the last command started, and
+// rows that may still show output from an earlier command.
+static uint8_t output_row;
+static uint8_t rows_used;
+static uint8_t rows_to_clear;
+
+// Main loop timing, kept by step_console()
+static uint32_t last_pass_time;
+static uint32_t passes;
+static uint16_t longest_pass;
+static uint32_t bench_start;
+
+// Terminal bytes queued when bench started, then the rate it measured
+static uint32_t bench_bytes;
+
+void init_console(void) {
+	typing = 0;
+	input_ready = 0;
+	input_changed = 0;
+	handler = 0;
+	output_row = 0;
+	rows_used = 0;
+	rows_to_clear = 0;
+	last_pass_time = get_clock_ticks();
+}
+
+uint8_t handle_console_input(char c) {
+	if (!typing) {
+		if (c == ':' && !input_ready) {
+			typing = 1;
+			input_length = 0;
+			input_changed = 1;
+			return 1;
+		}
+		return 0;
+	}
+	if (c == '\n') {
+		typing = 0;
+		input[input_length] = 0;
+		input_ready = input_length > 0;
+		input_changed = 1;
+	} else if (c == '\b' || c == 0x7F) {
+		if (input_length > 0) {
+			input_length--;
+		} else {
+			// backspace over the ':' gives up on the line
+			typing = 0;
+		}
+		input_changed = 1;
+	} else if (c >= ' ' && c < 0x7F && input_length < CONSOLE_INPUT_SIZE) {
+		input[input_length++] = c;
+		input_changed = 1;
+	}
+	return 1;
+}
+
+// sends the command line being typed, returns 0 if it didn't fit
+static uint8_t draw_input(void) {
+	if (!is_terminal_view_shown()) {
+		// the port is carrying raw telemetry
+		return 1;
+	}
+	if (channel_space(CHANNEL_TERMINAL) < TERMINAL_LINE_SPACE) {
+		return 0;
+	}
+	emit_move_cursor(CHANNEL_TERMINAL, 1, TERMINAL_CONSOLE_TOP);
+	emit_display_attribute(CHANNEL_TERMINAL, FG_WHITE);
+	// the line stays up after Enter until the next one is started
+	if (typing || input_ready) {
+		emit_char(CHANNEL_TERMINAL, ':');
+		emit_block(CHANNEL_TERMINAL, input, input_length);
+	}
+	emit_clear_to_end_of_line(CHANNEL_TERMINAL);
+	return 1;
+}
+
+// writes text (which may be empty) on the given output row
+static void draw_output_row(uint8_t row, const char* text) {
+	emit_move_cursor(CHANNEL_TERMINAL, 1, TERMINAL_CONSOLE_TOP + 1 + row);
+	emit_display_attribute(CHANNEL_TERMINAL, FG_WHITE);
+	emit_string(CHANNEL_TERMINAL, text);
+	emit_clear_to_end_of_line(CHANNEL_TERMINAL);
+}
+
+uint8_t console_print(const char* text) {
+	if (!is_terminal_view_shown()) {
+		// the port is carrying raw telemetry, throw the line away
+		return 1;
+	}
+	if (channel_space(CHANNEL_TERMINAL) < TERMINAL_LINE_SPACE) {
+		return 0;
+	}
+	draw_output_row(output_row, text);
+	output_row = (output_row + 1) % CONSOLE_ROWS;
+	if (rows_used < CONSOLE_ROWS) {
+		rows_used++;
+	}
+	return 1;
+}
+
+// answers anything not in the command table
+static uint8_t run_unknown(uint8_t step, char* args, char* out) {
+	strcpy_P(out, PSTR("unknown command, try help"));
+	return 0;
+}
+
+// looks up the command in command_line and gets it ready to run
+static void start_command(uint8_t source) {
+	char* name = command_line;
+	uint8_t length;
+	uint8_t i;
+	
+	while (*name == ' ') {
+		name++;
+	}
+	length = strcspn(name, " ");
+	command_args = name + length;
+	if (*command_args) {
+		*command_args++ = 0;
+		while (*command_args == ' ') {
+			command_args++;
+		}
+	}
+	
+	handler = run_unknown;
+	for (i = 0; length > 0 && length < sizeof(commands[0].usage) && i < NUM_COMMANDS; i++) {
+		const char* usage = commands[i].usage;
+		char after = pgm_read_byte(&usage[length]);
+		if (strncmp_P(name, usage, length) == 0 && (after == ' ' || after == 0)) {
+			handler = (CommandHandler)pgm_read_word(&commands[i].run);
+			break;
+		}
+	}
+	command_step = 0;
+	command_source = source;
+	if (source == FROM_TERMINAL) {
+		// new output starts at the top, anything below it is
+		// cleared once the command has finished
+		if (rows_used > rows_to_clear) {
+			rows_to_clear = rows_used;
+		}
+		rows_used = 0;
+		output_row = 0;
+	}
+}
+
+// sends a line (or, if empty, the end of a response) back to the host
+static void send_rpc_line(const char* text) {
+	char line[CONSOLE_LINE_SIZE + 2];
+	uint8_t length = strlen(text);
+	line[0] = rpc_id;
+	memcpy(line + 1, text, length);
+	line[length + 1] = '\n';
+	// all in one go so a line can't be split by another response
+	channel_write(CHANNEL_RPC, line, length + 2);
+}
+
+void step_console(void) {
+	char out[CONSOLE_LINE_SIZE + 1];
+	uint8_t request[RPC_REQUEST_SIZE];
+	uint8_t length;
+	uint8_t more;
+	uint32_t now = get_clock_ticks();
+	
+	// time since the last pass
+	if (now - last_pass_time > longest_pass) {
+		longest_pass = now - last_pass_time > 0xFFFF ? 0xFFFF : now - last_pass_time;
+	}
+	last_pass_time = now;
+	passes++;
+	
+	// one thing per pass - the command line first, so typing shows
+	if (input_changed) {
+		if (draw_input()) {
+			input_changed = 0;
+		}
+		return;
+	}
+	if (!handler) {
+		if (input_ready) {
+			strcpy(command_line, input);
+			input_ready = 0;
+			start_command(FROM_TERMINAL);
+		} else if ((length = get_rpc_request(request)) > 0) {
+			rpc_id = request[0];
+			memcpy(command_line, request + 1, length - 1);
+			command_line[length - 1] = 0;
+			command_line[strcspn(command_line, "\r\n")] = 0;
+			start_command(FROM_RPC);
+		} else {
+			// clear a row left over from an earlier command
+			if (rows_to_clear > rows_used && is_terminal_view_shown()
+					&& channel_space(CHANNEL_TERMINAL) >= TERMINAL_LINE_SPACE) {
+				rows_to_clear--;
+				draw_output_row(rows_to_clear, "");
+			}
+			return;
+		}
+	}
+	
+	if (command_source == FROM_RPC) {
+		if (channel_space(CHANNEL_RPC) < RPC_LINE_SPACE) {
+			return;
+		}
+	} else if (channel_space(CHANNEL_TERMINAL) < TERMINAL_LINE_SPACE) {
+		return;
+	}
+	out[0] = 0;
+	more = handler(command_step, command_args, out);
+	if (out[0]) {
+		if (command_source == FROM_RPC) {
+			send_rpc_line(out);
+		} else {
+			console_print(out);
+		}
+		command_step++;
+	}
+	if (!more) {
+		if (command_source == FROM_RPC) {
+			send_rpc_line("");
+		}
+		handler = 0;
+	}
+}
+
+// Reads a whole number from text. Returns 0 if text isn't one (or is
+// too big), otherwise 1 with the number in *value.
+static uint8_t parse_number(const char* text, uint16_t* value) {
+	uint32_t result = 0;
+	if (!*text) {
+		return 0;
+	}
+	for (; *text; text++) {
+		if (*text < '0' || *text > '9') {
+			return 0;
+		}
+		result = result * 10 + (*text - '0');
+		if (result > 0xFFFF) {
+			return 0;
+		}
+	}
+	*value = result;
+	return 1;
+}
+
+// Reads a number with up to two decimal places (e.g. 1.5) from text
+// as hundredths. Returns 0 if text isn't one.
+static uint8_t parse_hundredths(char* text, uint16_t* value) {
+	char* point = strchr(text, '.');
+	uint16_t whole = 0;
+	uint16_t fraction = 0;
+	uint8_t places = 0;
+	if (point) {
+		*point = 0;
+		places = strlen(point + 1);
+		if (places > 2 || (places > 0 && !parse_number(point + 1, &fraction))) {
+			return 0;
+		}
+		if (places == 1) {
+			fraction *= 10;
+		}
+	}
+	if ((*text || !point) && !parse_number(text, &whole)) {
+		return 0;
+	}
+	if (whole > 600) {
+		return 0;
+	}
+	*value = whole * 100 + fraction;
+	return 1;
+}
+
+static uint8_t run_help(uint8_t step, char* args, char* out) {
+	strcpy_P(out, commands[step].usage);
+	return step + 1 < NUM_COMMANDS;
+}
+
+static uint8_t run_stats(uint8_t step, char* args, char* out) {
+	TurnStats turns;
+	TerminalViewStats view;
+	TelemetryStats telemetry;
+	ChannelStats channel;
+	EepromWriterStats eeprom;
+	JournalStats journal;
+	char name[5];
+	
+	switch (step) {
+		case 0:
+			get_turn_stats(&turns);
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("turns: %u queued, %u reversed, %u full"),
+					turns.queued, turns.reversed, turns.overflowed);
+			break;
+		case 1:
+			get_terminal_view_stats(&view);
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("view: %u frames, %u dropped, %u deferred"),
+					view.frames, view.dropped, view.deferred);
+			break;
+		case 2:
+			get_telemetry_stats(&telemetry);
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("telemetry: %u packets, %u keys, %u dropped"),
+					telemetry.packets, telemetry.keyframes, telemetry.dropped);
+			break;
+		case 3:
+		case 4:
+		case 5:
+		case 6:
+			get_channel_stats(step - 3, &channel);
+			strcpy_P(name, channel_names[step - 3]);
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("%s: %lu bytes, %u dropped, %u frames"),
+					name, channel.bytes, channel.dropped, channel.frames);
+			break;
+		case 7:
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("input lag max %u/%u/%u ms, %u lost"),
+					get_input_max_latency(INPUT_BUTTON), get_input_max_latency(INPUT_JOYSTICK),
+					get_input_max_latency(INPUT_SERIAL), get_input_overflows());
+			break;
+		case 8:
+			get_eeprom_writer_stats(&eeprom);
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("eeprom: %u written, %u skipped, %u blocks"),
+					eeprom.written, eeprom.skipped, eeprom.blocks);
+			break;
+		case 9:
+			get_journal_stats(&journal);
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("journal: %u records, %u copied, %u/%u slots"),
+					journal.records, journal.copies, journal.slots_used, journal.slots);
+			break;
+		default:
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("loop: longest pass %u ms"), longest_pass);
+			return 0;
+	}
+	return 1;
+}
+
+// writes "x,y", or "none" if the position isn't valid, to out and
+// returns a pointer to the end of it
+static char* format_posn(char* out, PosnType posn) {
+	if (!is_position_valid(posn)) {
+		strcpy_P(out, PSTR("none"));
+		return out + 4;
+	}
+	out += format_uint(out, x_position(posn), 0);
+	*out++ = ',';
+	out += format_uint(out, y_position(posn), 0);
+	*out = 0;
+	return out;
+}
+
+static uint8_t run_state(uint8_t step, char* args, char* out) {
+	uint16_t speed = get_game_speed() * 100 + 0.5;
+	char* end;
+	int8_t i;
+	
+	switch (step) {
+		case 0:
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("score %lu, length %u, speed %u.%02u"),
+					get_score(), get_snake_length(), speed / 100, speed % 100);
+			break;
+		case 1:
+			end = stpcpy_P(out, PSTR("head "));
+			end = format_posn(end, get_snake_head_position());
+			end = stpcpy_P(end, PSTR(" tail "));
+			format_posn(end, get_snake_tail_position());
+			break;
+		case 2:
+			end = stpcpy_P(out, PSTR("rat "));
+			end = format_posn(end, get_position_of_rat());
+			end = stpcpy_P(end, PSTR(" super food "));
+			format_posn(end, is_there_super_food() ? get_position_of_super_food() : INVALID_POSITION);
+			break;
+		case 3:
+			// at most MAX_FOOD positions of up to 5 characters each
+			end = stpcpy_P(out, PSTR("food"));
+			for (i = 0; i < MAX_FOOD; i++) {
+				if (is_position_valid(get_position_of_food(i))) {
+					*end++ = ' ';
+					end = format_posn(end, get_position_of_food(i));
+				}
+			}
+			break;
+		case 4:
+			if (is_tron_mode()) {
+				end = stpcpy_P(out, PSTR("tron head "));
+				end = format_posn(end, get_tron_head_position());
+				end = stpcpy_P(end, PSTR(" tail "));
+				format_posn(end, get_tron_tail_position());
+			} else {
+				strcpy_P(out, PSTR("tron off"));
+			}
+			break;
+		case 5:
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("serial: %ld baud, framed %u, telemetry %u"),
+					get_serial_baud(), are_channels_framed(), is_telemetry_on());
+			break;
+		case 6:
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("game time %lu ms, hash %08lx"),
+					get_game_time(), get_state_hash());
+			break;
+		default:
+			snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("uptime %lu ms"), get_clock_ticks());
+			return 0;
+	}
+	return 1;
+}
+
+// changes the speed or a timing, and records the change so a replay
+// of this game makes it too. Returns 0 during a replay, which has to
+// run as recorded.
+static uint8_t change_setting(uint8_t setting, uint16_t value, char* out) {
+	if (is_replaying()) {
+		strcpy_P(out, PSTR("can't change that during a replay"));
+		return 0;
+	}
+	set_game_setting(setting, value);
+	record_setting(get_game_time(), setting, value);
+	return 1;
+}
+
+static uint8_t run_speed(uint8_t step, char* args, char* out) {
+	uint16_t speed;
+	if (*args) {
+		if (!parse_hundredths(args, &speed) || speed < MIN_SPEED || speed > MAX_SPEED) {
+			strcpy_P(out, PSTR("speed must be 0.10 to 3.00"));
+			return 0;
+		}
+		if (!change_setting(SETTING_SPEED, speed, out)) {
+			return 0;
+		}
+	}
+	speed = get_game_speed() * 100 + 0.5;
+	snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("speed %u.%02u"), speed / 100, speed % 100);
+	return 0;
+}
+
+static uint8_t run_timing(uint8_t step, char* args, char* out) {
+	char name[8];
+	char* value;
+	uint16_t time;
+	uint8_t i;
+	
+	if (!*args) {
+		// list them all, a line each
+		strcpy_P(name, timing_names[step]);
+		snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("%s %u ms"), name, get_game_timing(step));
+		return step + 1 < NUM_TIMINGS;
+	}
+	value = args + strcspn(args, " ");
+	if (*value) {
+		*value++ = 0;
+	}
+	for (i = 0; i < NUM_TIMINGS; i++) {
+		if (strcmp_P(args, timing_names[i]) == 0) {
+			break;
+		}
+	}
+	if (i == NUM_TIMINGS) {
+		strcpy_P(out, PSTR("timings are move rat sfcycle sflife refresh"));
+	} else if (*value && (!parse_number(value, &time) || time == 0)) {
+		strcpy_P(out, PSTR("time must be 1 to 65535 ms"));
+	} else if (!*value || change_setting(i, time, out)) {
+		snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("%s %u ms"), args, get_game_timing(i));
+	}
+	return 0;
+}
+
+// lists the saved game records, oldest first, as comma separated values
+static uint8_t run_games(uint8_t step, char* args, char* out) {
+	GameRecord record;
+	char death[6];
+	uint8_t count;
+	
+	if (step == 0) {
+		strcpy_P(out, PSTR("game,moves,food,rat,super,len,speed,s,ms,death"));
+		return 1;
+	}
+	// records are read from EEPROM, which has to wait for any writing
+	if (is_eeprom_writing()) {
+		return 1;
+	}
+	count = get_game_record_count();
+	if (step > count) {
+		return 0;
+	}
+	if (read_game_record(count - step, &record)) {
+		strcpy_P(death, death_names[record.death]);
+		snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("%u,%u,%u,%u,%u,%u,%u.%02u,%u,%u,%s"),
+				record.game, record.moves, record.food, record.rats, record.super_food,
+				record.longest, record.peak_speed / 100, record.peak_speed % 100,
+				record.duration, record.reaction, death);
+	} else {
+		strcpy_P(out, PSTR("damaged record"));
+	}
+	return step < count;
+}
+
+// lists the time from reset to the end of each boot stage
+static uint8_t run_boot(uint8_t step, char* args, char* out) {
+	char name[9];
+	uint32_t time = get_boot_stage_time(step);
+	strcpy_P(name, boot_stage_names[step]);
+	if (time == 0) {
+		snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("%s -"), name);
+	} else if (time >= BOOT_TIME_LIMIT) {
+		snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("%s over %lu ms"), name, BOOT_TIME_LIMIT / 1000);
+	} else {
+		snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("%s %lu.%03lu ms"), name, time / 1000, time % 1000);
+	}
+	return step + 1 < NUM_BOOT_STAGES;
+}
+
+static uint8_t run_bench(uint8_t step, char* args, char* out) {
+	uint32_t elapsed;
+	if (step == 0) {
+		passes = 0;
+		longest_pass = 0;
+		bench_start = get_clock_ticks();
+		bench_bytes = get_channel_output_count(CHANNEL_TERMINAL);
+		strcpy_P(out, PSTR("counting main loop passes..."));
+		return 1;
+	}
+	if (step == 2) {
+		// (includes the line above, about 30 bytes)
+		snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("terminal: %lu bytes/s"), bench_bytes);
+		return 0;
+	}
+	elapsed = get_clock_ticks() - bench_start;
+	if (elapsed < BENCH_TIME) {
+		return 1;
+	}
+	bench_bytes = (get_channel_output_count(CHANNEL_TERMINAL) - bench_bytes) * 1000 / elapsed;
+	snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("loop: %lu passes/s, longest pass %u ms"),
+			passes * 1000 / elapsed, longest_pass);
+	return 1;
+}
+
+// ends the game being played, which replay.c has been recording, and
+// has it replayed
+static uint8_t run_replay(uint8_t step, char* args, char* out) {
+	uint16_t speed = 1;
+	if (*args && (!parse_number(args, &speed) || speed < 1 || speed > MAX_REPLAY_SPEED)) {
+		snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("speed must be 1 to %u"), MAX_REPLAY_SPEED);
+		return 0;
+	}
+	if (!can_replay()) {
+		strcpy_P(out, PSTR("this game can't be replayed"));
+		return 0;
+	}
+	request_replay(speed);
+	snprintf_P(out, CONSOLE_LINE_SIZE + 1, PSTR("replaying at %ux"), speed);
+	return 0;
+}
+
+static uint8_t run_ping(uint8_t step, char* args, char* out) {
+	strcpy_P(out, PSTR("pong"));
+	return 0;
+}
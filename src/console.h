@@ -0,0 +1,83 @@
+/*
+** console.h
+**
+** Written by Arda Akgur
+**
+** A command console for looking at and adjusting the game while it
+** runs. On the terminal, ':' starts a command line, Backspace edits
+** it and Enter runs it (arrow keys still steer while typing). The line
+** is shown at TERMINAL_CONSOLE_TOP and the output in the rows below
+** it. With channels framed, the host can also
+** send a command as an RPC request (an id byte then the command line);
+** each output line comes back as the id, the text and a \n, and an
+** empty line (the id then \n) ends the response.
+**
+** Commands (see help):
+**   help              list the commands
+**   stats             counters from the snake, view, telemetry,
+**                     channels, input, EEPROM writer and main loop
+**   state             dump the game state
+**   speed [x.xx]      show or set the game speed
+**   timing [name ms]  show the main loop timings or change one
+**   games             list the saved game records as comma separated values
+**   boot              show how long each boot stage took from reset
+**   bench             measure main loop passes and terminal output
+**                     bytes for a second
+**   replay [speed]    replay this game from the start, 1 to 9 times
+**                     real time (or restart the replay being shown)
+**   ping              answer pong
+**
+** Nothing here waits. Keys are only stored as they arrive and
+** step_console() runs at most one step of a command per call, sending
+** at most one line of output, and only when there is room for it.
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef CONSOLE_H_
+#define CONSOLE_H_
+
+#include <inttypes.h>
+
+// Longest command line (not counting the ':')
+#define CONSOLE_INPUT_SIZE 32
+
+// Longest line of output
+#define CONSOLE_LINE_SIZE 48
+
+// Output rows below the command line on the terminal. Output past the
+// last row goes back to the first.
+#define CONSOLE_ROWS 8
+
+/* init_console()
+**
+** Forget any command being typed or run. Call at the start of a game,
+** once the terminal view has been drawn.
+*/
+void init_console(void);
+
+/* handle_console_input(c)
+**
+** Pass a serial command character to the console. Returns 1 if it was
+** used (':' or part of a command line), 0 if it should be handled as
+** usual.
+*/
+uint8_t handle_console_input(char c);
+
+/* step_console()
+**
+** Redraw the command line if it changed, take an RPC request if there
+** is one, and run the next step of the current command. Call once per
+** pass of the main loop - this also keeps the main loop timings shown
+** by stats and bench.
+*/
+void step_console(void);
+
+/* console_print(text)
+**
+** Write a line of text (at most CONSOLE_LINE_SIZE characters) to the
+** next terminal output row. Returns 1 if it was queued, 0 if there
+** wasn't room for it.
+*/
+uint8_t console_print(const char* text);
+
+#endif
@@ -0,0 +1,29 @@
+/*
+** eeprom_layout.h
+**
+** Written by Arda Akgur
+**
+** Where everything kept in EEPROM lives. All EEPROM addresses used by
+** the game are defined here, so regions can't overlap by accident.
+** The ATmega324A has 1024 bytes of EEPROM (0x000 to 0x3FF).
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef EEPROM_LAYOUT_H_
+#define EEPROM_LAYOUT_H_
+
+#define EEPROM_SIZE 1024
+
+// Leaderboard entry slots (see leaderboard.c), 0x000 up to 0x1FF
+#define EEPROM_LEADERBOARD 0x000
+#define EEPROM_LEADERBOARD_SIZE 0x200
+
+// Journal of saved records (see journal.c), 0x200 up to 0x37F
+#define EEPROM_JOURNAL 0x200
+#define EEPROM_JOURNAL_SIZE 0x180
+
+// Ring of per-game records (see game_record.c), 0x380 up to 0x3FF
+#define EEPROM_GAME_RECORDS 0x380
+#define EEPROM_GAME_RECORDS_SIZE 0x80
+
+#endif
@@ -0,0 +1,114 @@
+/*
+** eeprom_writer.c
+**
+** Written by Arda Akgur
+**
+** The queue is a ring of blocks: write_eeprom_block() (main program
+** only) fills the slot at the head and then moves the head, the
+** interrupt handler works through the block at the tail. The EEPROM
+** ready interrupt keeps firing for as long as it is enabled and the
+** EEPROM isn't busy, so each call handles just one byte and the next
+** call follows as soon as that byte is programmed (or straight away if
+** it was skipped). It is turned off when the queue is empty.
+*/
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "eeprom_writer.h"
+
+// data is an EEPROM address if from_eeprom is set
+typedef struct {
+	uint16_t address;
+	const uint8_t* data;
+	uint8_t length;
+	uint8_t from_eeprom;
+	EepromDoneCallback done;
+} EepromBlock;
+
+static EepromBlock queue[EEPROM_QUEUE_SIZE];
+static volatile uint8_t queue_head;
+static volatile uint8_t queue_tail;
+
+// next byte of the block at the tail, only used by the interrupt
+static uint8_t offset;
+
+static volatile EepromWriterStats stats;
+
+static uint8_t queue_block(uint16_t address, const uint8_t* data, uint8_t length,
+		uint8_t from_eeprom, EepromDoneCallback done) {
+	uint8_t next = (queue_head + 1) % EEPROM_QUEUE_SIZE;
+	if (next == queue_tail) {
+		return 0;
+	}
+	queue[queue_head].address = address;
+	queue[queue_head].data = data;
+	queue[queue_head].length = length;
+	queue[queue_head].from_eeprom = from_eeprom;
+	queue[queue_head].done = done;
+	queue_head = next;
+	EECR |= (1<<EERIE);
+	return 1;
+}
+
+uint8_t write_eeprom_block(uint16_t address, const void* data, uint8_t length,
+		EepromDoneCallback done) {
+	return queue_block(address, data, length, 0, done);
+}
+
+uint8_t copy_eeprom_block(uint16_t to, uint16_t from, uint8_t length,
+		EepromDoneCallback done) {
+	return queue_block(to, (const uint8_t*)from, length, 1, done);
+}
+
+uint8_t is_eeprom_writing(void) {
+	return queue_head != queue_tail;
+}
+
+void get_eeprom_writer_stats(EepromWriterStats* writer_stats) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		*writer_stats = stats;
+	}
+}
+
+ISR(EE_READY_vect) {
+	EepromBlock* block;
+	uint8_t data;
+	
+	if (queue_tail == queue_head) {
+		EECR &= ~(1<<EERIE);
+		return;
+	}
+	block = &queue[queue_tail];
+	if (offset == block->length) {
+		// the EEPROM is ready, so the last byte has been programmed
+		offset = 0;
+		queue_tail = (queue_tail + 1) % EEPROM_QUEUE_SIZE;
+		stats.blocks++;
+		if (block->done) {
+			block->done();
+		}
+		return;
+	}
+	
+	if (block->from_eeprom) {
+		EEAR = (uint16_t)block->data + offset;
+		EECR |= (1<<EERE);
+		data = EEDR;
+	} else {
+		data = block->data[offset];
+	}
+	EEAR = block->address + offset;
+	offset++;
+	EECR |= (1<<EERE);
+	if (EEDR == data) {
+		stats.skipped++;
+		return;
+	}
+	EEDR = data;
+	// erase and write in one operation (EEPM bits 0) - EEPE must be
+	// set within four cycles of EEMPE
+	EECR = (1<<EERIE) | (1<<EEMPE);
+	EECR |= (1<<EEPE);
+	stats.written++;
+}
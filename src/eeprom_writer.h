@@ -0,0 +1,71 @@
+/*
+** eeprom_writer.h
+**
+** Written by Arda Akgur
+**
+** Writing blocks to EEPROM in the background. An EEPROM byte takes
+** about 3.4ms to program, so rather than waiting in eeprom_write_*()
+** blocks are queued and the EEPROM ready interrupt programs them a
+** byte at a time while the game carries on. Bytes that already hold
+** the right value are skipped (and so cost no write cycle).
+**
+** The data of a queued block is read as it is written, so it must not
+** change until the block is done. While anything is queued the EEPROM
+** must not be read or written any other way - wait for
+** is_eeprom_writing() to return 0 first.
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef EEPROM_WRITER_H_
+#define EEPROM_WRITER_H_
+
+#include <inttypes.h>
+
+// Size of the block queue. One entry is always left empty to tell a
+// full queue from an empty one, so at most EEPROM_QUEUE_SIZE - 1
+// blocks can be waiting at once.
+#define EEPROM_QUEUE_SIZE 8
+
+// Called (from the interrupt handler, so it must be quick) once every
+// byte of a block has been programmed
+typedef void (*EepromDoneCallback)(void);
+
+// Bytes programmed and skipped, and blocks finished, since reset
+typedef struct {
+	uint16_t written;
+	uint16_t skipped;
+	uint16_t blocks;
+} EepromWriterStats;
+
+/* write_eeprom_block(address, data, length, done)
+**
+** Queue length bytes from data to be written at the given EEPROM
+** address. done (which can be 0) is called once they have all been
+** programmed. Returns 1 if the block was queued, 0 if the queue is
+** full. Interrupts must be on for the block to be written.
+*/
+uint8_t write_eeprom_block(uint16_t address, const void* data, uint8_t length,
+		EepromDoneCallback done);
+
+/* copy_eeprom_block(to, from, length, done)
+**
+** As write_eeprom_block(), but the data comes from EEPROM (starting at
+** address from) and is read just before each byte is written.
+*/
+uint8_t copy_eeprom_block(uint16_t to, uint16_t from, uint8_t length,
+		EepromDoneCallback done);
+
+/* is_eeprom_writing()
+**
+** Returns 1 while any queued block hasn't been completely programmed,
+** 0 otherwise.
+*/
+uint8_t is_eeprom_writing(void);
+
+/* get_eeprom_writer_stats(stats)
+**
+** Copy the counters into *stats.
+*/
+void get_eeprom_writer_stats(EepromWriterStats* stats);
+
+#endif
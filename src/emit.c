@@ -0,0 +1,74 @@
+/*
+** emit.c
+**
+** Written by Arda Akgur
+**
+** Direct output routines. Numbers are converted with 16 bit division
+** whenever they fit, since a 32 bit divide on the AVR is a library
+** call several times slower and nearly every number we print (cursor
+** rows and columns, colours, scores) is small.
+*/
+
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "emit.h"
+#include "channel.h"
+
+uint8_t format_uint(char* buffer, uint32_t value, uint8_t width) {
+	char digits[EMIT_NUMBER_SIZE];
+	uint8_t count = 0;
+	uint8_t length = 0;
+	uint16_t small;
+	
+	// digits come out least significant first
+	while (value > 0xFFFF) {
+		digits[count++] = '0' + value % 10;
+		value /= 10;
+	}
+	small = value;
+	do {
+		digits[count++] = '0' + small % 10;
+		small /= 10;
+	} while (small);
+	
+	while (width > count) {
+		buffer[length++] = ' ';
+		width--;
+	}
+	while (count) {
+		buffer[length++] = digits[--count];
+	}
+	return length;
+}
+
+uint8_t emit_block(uint8_t channel, const char* data, uint8_t length) {
+	if (channel_space(channel) < length) {
+		return 0;
+	}
+	channel_write(channel, data, length);
+	return 1;
+}
+
+uint8_t emit_char(uint8_t channel, char c) {
+	return emit_block(channel, &c, 1);
+}
+
+uint8_t emit_string(uint8_t channel, const char* string) {
+	return emit_block(channel, string, strlen(string));
+}
+
+uint8_t emit_string_P(uint8_t channel, const char* string) {
+	if (channel_space(channel) < strlen_P(string)) {
+		return 0;
+	}
+	channel_write_P(channel, string);
+	return 1;
+}
+
+uint8_t emit_uint(uint8_t channel, uint32_t value, uint8_t width) {
+	char buffer[EMIT_NUMBER_SIZE];
+	if (width > EMIT_NUMBER_SIZE) {
+		width = EMIT_NUMBER_SIZE;
+	}
+	return emit_block(channel, buffer, format_uint(buffer, value, width));
+}
@@ -0,0 +1,58 @@
+/*
+** emit.h
+**
+** Written by Arda Akgur
+**
+** Small output routines for code that runs every frame. They write
+** characters, strings and numbers straight into a channel queue (or
+** the serial output ring when channels aren't framed) without going
+** through printf and the stdio stream layer. None of them wait: each
+** returns 1 if everything was queued and 0 if it didn't fit, in which
+** case nothing was queued at all.
+*/
+
+#ifndef EMIT_H_
+#define EMIT_H_
+
+#include <stdint.h>
+
+/* Longest output of format_uint() - 10 digits, or the width if wider */
+#define EMIT_NUMBER_SIZE 10
+
+/* format_uint(buffer, value, width)
+**
+** Write value in decimal to buffer, right aligned and padded with
+** spaces to at least width characters (like printf's "%5lu" for a
+** width of 5). No terminating 0 is added. Returns the number of
+** characters written, at most the larger of width and EMIT_NUMBER_SIZE.
+*/
+uint8_t format_uint(char* buffer, uint32_t value, uint8_t width);
+
+/* emit_char(channel, c)
+**
+** Queue a single character.
+*/
+uint8_t emit_char(uint8_t channel, char c);
+
+/* emit_string(channel, string)
+** emit_string_P(channel, string)
+**
+** Queue a string from data memory or program memory.
+*/
+uint8_t emit_string(uint8_t channel, const char* string);
+uint8_t emit_string_P(uint8_t channel, const char* string);
+
+/* emit_uint(channel, value, width)
+**
+** Queue value as formatted by format_uint(). Widths above
+** EMIT_NUMBER_SIZE are treated as EMIT_NUMBER_SIZE.
+*/
+uint8_t emit_uint(uint8_t channel, uint32_t value, uint8_t width);
+
+/* emit_block(channel, data, length)
+**
+** Queue length bytes only if all of them fit.
+*/
+uint8_t emit_block(uint8_t channel, const char* data, uint8_t length);
+
+#endif
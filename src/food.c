@@ -12,6 +12,8 @@
 #include "superFood.h"
 #include "tron.h"
 #include "rat.h"
+#include "prng.h"
+#include "state_hash.h"
 
 /*
 ** Global variables.
@@ -64,19 +66,16 @@ PosnType add_food_item(void) {
 		// Can't fit any more food items in our list
 		return INVALID_POSITION;
 	}
-	/* Generate "random" positions until we get one which
+	/* Generate random positions until we get one which
 	** is not occupied by a snake or food.
 	*/
 	int8_t x, y, attempts;
 	PosnType test_position;
-	x = 0;
-	y = 0;
 	attempts = 0;
 	do {
-		// Generate a new position - this is based on a sequence rather
-		// then being random
-        x = (x+3+attempts)%BOARD_WIDTH;
-        y = (y+5)%BOARD_HEIGHT;
+		// Generate a new random position
+        x = random_below(BOARD_WIDTH);
+        y = random_below(BOARD_HEIGHT);
 		test_position = position(x,y);
         attempts++;
     } while(attempts < 100 && 
@@ -94,6 +93,7 @@ PosnType add_food_item(void) {
 	int8_t newFoodID = numFoodItems;
 	foodPositions[newFoodID] = test_position;
 	numFoodItems++;
+	toggle_state_hash(HASH_FOOD, test_position);
 	return test_position;
 }
 
@@ -104,6 +104,19 @@ PosnType get_position_of_food(int8_t foodID) {
 	return foodPositions[foodID];
 }
 
+/* Return the number of food items.
+*/
+int8_t get_num_food_items(void) {
+	return numFoodItems;
+}
+
+/* Add a food item at the given position.
+*/
+void restore_food_item(PosnType posn) {
+	foodPositions[numFoodItems] = posn;
+	numFoodItems++;
+}
+
 /*
 ** Remove the food item from our list of food
 */
@@ -114,6 +127,7 @@ void remove_food(int8_t foodID) {
         /* Invalid foodID */
         return;
     }
+	toggle_state_hash(HASH_FOOD, foodPositions[foodID]);
 	     
     /* Shuffle our list of food items along so there are
 	** no holes in our list 
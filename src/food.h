@@ -63,6 +63,20 @@ PosnType add_food_item(void);
 */
 PosnType get_position_of_food(int8_t foodID);
 
+/* get_num_food_items()
+**
+** Returns the number of food items on the board. Food IDs go from
+** 0 to one less than this.
+*/
+int8_t get_num_food_items(void);
+
+/* restore_food_item(position)
+**
+** Add a food item at the given position (e.g. one saved earlier)
+** without any checks. There must be fewer than MAX_FOOD items.
+*/
+void restore_food_item(PosnType posn);
+
 /* remove_food(foodID)
 **
 ** Remove a food item from our list of food. This could 
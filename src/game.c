@@ -10,9 +10,13 @@
 #include "pixel_colour.h"
 #include "board.h"
 #include "ledmatrix.h"
-#include "timer0.h"
 #include "superFood.h"
 #include "rat.h"
+#include "tron.h"
+#include "animation.h"
+#include "terminal_view.h"
+#include "game_record.h"
+#include "state_hash.h"
 
 // Colours that we'll use
 #define SNAKE_HEAD_COLOUR	COLOUR_RED
@@ -21,10 +25,20 @@
 #define BACKGROUND_COLOUR	COLOUR_BLACK
 #define SUPER_FOOD_COLOUR   COLOUR_ORANGE
 #define RAT_COLOUR			COLOUR_ARC
+#define TRON_HEAD_COLOUR	COLOUR_ARC
+#define TRON_BODY_COLOUR	COLOUR_RED
 
 // game speed val, default 1.0
 static float game_speed = 1.0;
 
+// main loop timings, indexed by GameTiming
+static uint16_t timings[NUM_TIMINGS] = {
+	600, 1000, 15000, 5000, TERMINAL_REFRESH_TIME
+};
+
+// game time, from 0 at the start of the game
+static uint32_t game_time;
+
 // super food timer
 static uint32_t super_food_timer;
 
@@ -39,8 +53,11 @@ static void update_display_at_position(PosnType posn, PixelColour colour) {
 // Initialise game. This initialises the board with snake and food items 
 // and puts them on the display.
 void init_game(void) {
-	// Clear display
+	// Clear display and stop any animations left from the last game
 	ledmatrix_clear();
+	init_animations();
+	game_time = 0;
+	super_food_timer = 0;
 	
 	// Initialise the snake and display it. We know the initial snake is only
 	// of length two so we can just retrieve the tail and head positions
@@ -60,13 +77,58 @@ void init_game(void) {
 	PosnType super_food_pos = add_super_food_item();
 	if (is_position_valid(super_food_pos)) {
 		update_display_at_position(super_food_pos, SUPER_FOOD_COLOUR);
-		super_food_timer = get_clock_ticks();
 	}
 	// initialises rat	
 	PosnType rat_position = add_rat_item();
 	if (is_position_valid(rat_position)) {
 		update_display_at_position(rat_position, RAT_COLOUR);
 	}
+	reset_state_hash();
+}
+
+// draws the whole board from scratch
+void redraw_game(void) {
+	uint8_t x, y;
+	ledmatrix_clear();
+	init_animations();
+	for (x = 0; x < BOARD_WIDTH; x++) {
+		for (y = 0; y < BOARD_HEIGHT; y++) {
+			PixelColour colour = get_colour_at_position(position(x, y));
+			if (colour != BACKGROUND_COLOUR) {
+				update_display_at_position(position(x, y), colour);
+			}
+		}
+	}
+}
+
+// returns the colour the given board position should be showing
+PixelColour get_colour_at_position(PosnType posn) {
+	if (posn == get_snake_head_position()) {
+		return SNAKE_HEAD_COLOUR;
+	} else if (is_snake_at(posn)) {
+		return SNAKE_BODY_COLOUR;
+	} else if (is_tron_mode() && posn == get_tron_head_position()) {
+		return TRON_HEAD_COLOUR;
+	} else if (is_tron_mode() && is_tron_at(posn)) {
+		return TRON_BODY_COLOUR;
+	} else if (is_rat_at(posn)) {
+		return RAT_COLOUR;
+	} else if (is_food_at(posn)) {
+		return FOOD_COLOUR;
+	} else if (is_super_food_at(posn)) {
+		return SUPER_FOOD_COLOUR;
+	}
+	return BACKGROUND_COLOUR;
+}
+
+// returns game time
+uint32_t get_game_time(void) {
+	return game_time;
+}
+
+// sets game time
+void set_game_time(uint32_t time) {
+	game_time = time;
 }
 
 // returns suepr food timer
@@ -84,15 +146,40 @@ float get_game_speed(void) {
 	return game_speed;
 }
 
+// sets game speed
+void set_game_speed(float speed) {
+	game_speed = speed;
+}
+
 // resets game speed
 void reset_game_speed(void) {
 	game_speed = 1.0;
 }
 
+// returns one of the main loop timings
+uint16_t get_game_timing(GameTiming timing) {
+	return timings[timing];
+}
+
+// changes one of the main loop timings
+void set_game_timing(GameTiming timing, uint16_t time) {
+	timings[timing] = time;
+}
+
+// changes the speed or a timing by setting number
+void set_game_setting(uint8_t setting, uint16_t value) {
+	if (setting == SETTING_SPEED) {
+		game_speed = value / 100.0;
+	} else if (setting < NUM_TIMINGS) {
+		timings[setting] = value;
+	}
+}
+
 // Attempt to move snake forward. Returns true if successful, false otherwise
 int8_t attempt_to_move_snake_forward(void) {
 	PosnType prior_head_position = get_snake_head_position();
 	int8_t move_result = advance_snake_head();
+	record_move(move_result);
 	if(move_result < 0) {
 		// Snake moved out of bounds (if this is not permitted) or
 		// collided it with itself. Return false because we couldn't
@@ -151,6 +238,9 @@ int8_t attempt_to_move_snake_forward(void) {
 	// update the new head position.
 	update_display_at_position(prior_head_position, SNAKE_BODY_COLOUR);
 	update_display_at_position(new_head_position, SNAKE_HEAD_COLOUR);
+	if (move_result != MOVE_OK) {
+		start_animation(ANIM_EAT, new_head_position);
+	}
 	return 1;
 }
 
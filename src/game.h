@@ -8,12 +8,53 @@
 #define GAME_H_
 
 #include <inttypes.h>
+#include "pixel_colour.h"
+#include "position.h"
+
+// Game time (in milliseconds) only moves on while the game is being
+// played - it stands still while paused and can run faster than the
+// clock for a replay. All game timers use it.
+uint32_t get_game_time(void);
+void set_game_time(uint32_t time);
 
 uint32_t get_super_food_timer(void);
 void set_super_food_timer(uint32_t time);
 float get_game_speed(void);
+void set_game_speed(float speed);
 void reset_game_speed(void);
 
+// Times (in milliseconds) used by the main loop. They start at their
+// defaults and can be changed from the serial console - changes last
+// until the next reset, across games.
+typedef enum {
+	TIMING_MOVE,			// between snake moves at speed 1.0
+	TIMING_RAT,				// between rat moves
+	TIMING_SUPER_FOOD_CYCLE,	// from one super food appearing to the next
+	TIMING_SUPER_FOOD_LIFE,	// how long super food stays, blinking for its last second
+	TIMING_REFRESH,			// between terminal view frames
+	NUM_TIMINGS
+} GameTiming;
+
+uint16_t get_game_timing(GameTiming timing);
+void set_game_timing(GameTiming timing, uint16_t time);
+
+// Setting numbers for set_game_setting() - the timings by their
+// GameTiming, then the speed (in hundredths)
+#define SETTING_SPEED NUM_TIMINGS
+
+// Change the speed or one of the timings the way the console does, so
+// a replay can make the same change (see replay.h)
+void set_game_setting(uint8_t setting, uint16_t value);
+
+// Clear the display and draw every board position again, for when
+// the game has been changed other than by moving (e.g. restored from
+// a snapshot).
+void redraw_game(void);
+
+// Returns the colour that the given board position should currently
+// be showing on the LED matrix (based on what occupies it).
+PixelColour get_colour_at_position(PosnType posn);
+
 // Initialise game. This initialises the board with snake and food items
 // and initialises the display.
 void init_game(void);
@@ -0,0 +1,215 @@
+/*
+** game_record.c
+**
+** Written by Arda Akgur
+**
+** A record in EEPROM is
+**   game number, moves (2 bytes), food, rats, super food,
+**   longest length (low 6 bits) and cause of death (high 2 bits),
+**   peak speed (hundredths over 1.00), duration (2 bytes),
+**   reaction time (4ms units), CRC-8 of the bytes before it
+** with 2 byte values stored low byte first. Records are written in
+** turn round the ring, the newest is the valid one with the highest
+** game number. A record cut short by a reset fails its CRC and is
+** skipped, which only loses the oldest game.
+**
+** The ring is found on first use rather than at boot.
+*/
+
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "game_record.h"
+#include "eeprom_layout.h"
+#include "eeprom_writer.h"
+#include "snake.h"
+#include "game.h"
+#include "timer0.h"
+
+#define GAME_RECORD_SIZE 12
+#define NUM_GAME_RECORDS (EEPROM_GAME_RECORDS_SIZE / GAME_RECORD_SIZE)
+
+#define NOT_FOUND 0xFF
+
+// the game being played
+static GameRecord current;
+static uint32_t start_time;
+
+// ring slot of the newest record, NOT_FOUND until the ring has been
+// scanned, or NUM_GAME_RECORDS if there isn't one
+static uint8_t newest = NOT_FOUND;
+static uint8_t count;
+
+// the record being written
+static uint8_t packed[GAME_RECORD_SIZE];
+
+static uint16_t record_address(uint8_t slot) {
+	return EEPROM_GAME_RECORDS + slot * GAME_RECORD_SIZE;
+}
+
+static uint8_t packed_crc(void) {
+	uint8_t crc = 0;
+	uint8_t i;
+	for (i = 0; i < GAME_RECORD_SIZE - 1; i++) {
+		crc = _crc8_ccitt_update(crc, packed[i]);
+	}
+	return crc;
+}
+
+// reads the record in the slot into packed, returns 1 if it is valid
+static uint8_t read_packed(uint8_t slot) {
+	// reading while the writer is busy could clash with it
+	while (is_eeprom_writing()) {
+		;
+	}
+	eeprom_read_block(packed, (const void*)record_address(slot), GAME_RECORD_SIZE);
+	return packed[GAME_RECORD_SIZE - 1] == packed_crc();
+}
+
+// finds the newest record and counts the valid ones
+static void scan_records(void) {
+	uint8_t newest_game = 0;
+	uint8_t slot;
+	newest = NUM_GAME_RECORDS;
+	count = 0;
+	for (slot = 0; slot < NUM_GAME_RECORDS; slot++) {
+		if (read_packed(slot)) {
+			// game numbers wrap, so compare differences
+			if (newest == NUM_GAME_RECORDS || (int8_t)(packed[0] - newest_game) > 0) {
+				newest = slot;
+				newest_game = packed[0];
+			}
+			count++;
+		}
+	}
+}
+
+void start_game_record(void) {
+	current.moves = 0;
+	current.food = 0;
+	current.rats = 0;
+	current.super_food = 0;
+	current.longest = get_snake_length();
+	current.peak_speed = 0;
+	current.death = DEATH_NONE;
+	start_time = get_clock_ticks();
+}
+
+static void count_up(uint8_t* counter) {
+	if (*counter < 0xFF) {
+		(*counter)++;
+	}
+}
+
+// notes the speed if it is the highest yet
+static void check_speed(void) {
+	uint16_t speed = get_game_speed() * 100 + 0.5;
+	if (speed > current.peak_speed) {
+		current.peak_speed = speed;
+	}
+}
+
+void record_move(int8_t move_result) {
+	switch (move_result) {
+		case MOVE_OK:
+			current.moves++;
+			return;
+		case ATE_FOOD:
+		case ATE_FOOD_BUT_CANT_GROW:
+			count_up(&current.food);
+			break;
+		case ATE_RAT:
+		case ATE_RAT_BUT_CANT_GROW:
+			count_up(&current.rats);
+			break;
+		case ATE_SUPER_FOOD:
+		case ATE_SUPER_FOOD_BUT_CANT_GROW:
+			count_up(&current.super_food);
+			break;
+		case COLLISION:
+			current.death = DEATH_SELF;
+			return;
+		case TRON_COLLISION:
+			current.death = DEATH_TRON;
+			return;
+		default:
+			current.death = DEATH_OTHER;
+			return;
+	}
+	// something was eaten - the only time length or speed go up
+	current.moves++;
+	if (get_snake_length() > current.longest) {
+		current.longest = get_snake_length();
+	}
+	check_speed();
+}
+
+void end_game_record(void) {
+	uint32_t duration = (get_clock_ticks() - start_time) / 1000;
+	uint16_t peak_speed;
+	TurnStats turns;
+	uint8_t slot;
+	
+	if (newest == NOT_FOUND) {
+		scan_records();
+	}
+	if (newest == NUM_GAME_RECORDS) {
+		slot = 0;
+		current.game = 1;
+	} else {
+		read_packed(newest);
+		slot = (newest + 1) % NUM_GAME_RECORDS;
+		current.game = packed[0] + 1;
+	}
+	check_speed();
+	get_turn_stats(&turns);
+	current.duration = duration > 0xFFFF ? 0xFFFF : duration;
+	current.reaction = turns.taken ? turns.waited / turns.taken : 0;
+	
+	peak_speed = current.peak_speed < 100 ? 0 : current.peak_speed - 100;
+	packed[0] = current.game;
+	packed[1] = current.moves & 0xFF;
+	packed[2] = current.moves >> 8;
+	packed[3] = current.food;
+	packed[4] = current.rats;
+	packed[5] = current.super_food;
+	packed[6] = (current.longest & 0x3F) | (current.death << 6);
+	packed[7] = peak_speed > 0xFF ? 0xFF : peak_speed;
+	packed[8] = current.duration & 0xFF;
+	packed[9] = current.duration >> 8;
+	packed[10] = current.reaction / 4 > 0xFF ? 0xFF : current.reaction / 4;
+	packed[11] = packed_crc();
+	while (!write_eeprom_block(record_address(slot), packed, GAME_RECORD_SIZE, 0)) {
+		;
+	}
+	if (count < NUM_GAME_RECORDS) {
+		count++;
+	}
+	newest = slot;
+}
+
+uint8_t get_game_record_count(void) {
+	if (newest == NOT_FOUND) {
+		scan_records();
+	}
+	return count;
+}
+
+uint8_t read_game_record(uint8_t age, GameRecord* record) {
+	if (age >= get_game_record_count()) {
+		return 0;
+	}
+	if (!read_packed((newest + NUM_GAME_RECORDS - age) % NUM_GAME_RECORDS)) {
+		return 0;
+	}
+	record->game = packed[0];
+	record->moves = packed[1] | (packed[2] << 8);
+	record->food = packed[3];
+	record->rats = packed[4];
+	record->super_food = packed[5];
+	record->longest = packed[6] & 0x3F;
+	record->death = packed[6] >> 6;
+	record->peak_speed = packed[7] + 100;
+	record->duration = packed[8] | (packed[9] << 8);
+	record->reaction = packed[10] * 4;
+	return 1;
+}
@@ -0,0 +1,73 @@
+/*
+** game_record.h
+**
+** Written by Arda Akgur
+**
+** Statistics about each game played. Counters are kept in RAM while
+** the game goes on, then packed into a GAME_RECORD_SIZE byte record
+** and added to a ring of records in EEPROM when it ends, so the last
+** few games can be dumped over serial (see the games console command).
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef GAME_RECORD_H_
+#define GAME_RECORD_H_
+
+#include <inttypes.h>
+
+// How a game ended
+typedef enum {
+	DEATH_SELF,			// snake ran into itself
+	DEATH_TRON,			// snake ran into the Tron
+	DEATH_OTHER,		// any other failed move
+	DEATH_NONE			// game still going
+} DeathCause;
+
+typedef struct {
+	uint8_t game;			// game number, counts up and wraps
+	uint16_t moves;
+	uint8_t food;			// counts stop at 255
+	uint8_t rats;
+	uint8_t super_food;
+	uint8_t longest;		// longest the snake got
+	uint16_t peak_speed;	// in hundredths
+	uint16_t duration;		// seconds, including any time paused
+	uint16_t reaction;		// average ms from a turn being made to the snake turning
+	uint8_t death;			// DeathCause
+} GameRecord;
+
+/* start_game_record()
+**
+** Reset the counters and start timing a new game.
+*/
+void start_game_record(void);
+
+/* record_move(move_result)
+**
+** Count a move with the given result from advance_snake_head().
+** Called for every move, so it does very little.
+*/
+void record_move(int8_t move_result);
+
+/* end_game_record()
+**
+** Finish the record for the game just played and start writing it
+** to EEPROM in the background, over the oldest record if the ring is
+** full. Must be called before the game speed is reset.
+*/
+void end_game_record(void);
+
+/* get_game_record_count()
+**
+** Returns the number of valid records in EEPROM.
+*/
+uint8_t get_game_record_count(void);
+
+/* read_game_record(age, record)
+**
+** Read the record age games back (0 is the last game) into *record.
+** Returns 1 if there is a valid record there, 0 otherwise.
+*/
+uint8_t read_game_record(uint8_t age, GameRecord* record);
+
+#endif
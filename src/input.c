@@ -0,0 +1,129 @@
+/*
+** input.c
+**
+** Written by Arda Akgur
+**
+** Single producer, single consumer ring of input events. The interrupt
+** handlers only write the head index and the main program only writes
+** the tail index, so no interrupts need to be disabled to read events.
+** The indexes are 8 bits and run freely, wrapping naturally - the
+** number of events in the queue is always head - tail.
+*/
+
+#include <avr/io.h>
+#include "input.h"
+#include "serialio.h"
+#include "snake.h"
+#include "timer0.h"
+
+#define INPUT_QUEUE_MASK (INPUT_QUEUE_SIZE - 1)
+
+// ASCII code for Escape character
+#define ESCAPE_CHAR 27
+
+// Stops the compiler moving memory accesses across this point, so an
+// event is completely written (or read) before the index moves on
+#define memory_barrier() __asm__ __volatile__("" ::: "memory")
+
+static InputEvent queue[INPUT_QUEUE_SIZE];
+static volatile uint8_t queue_head;
+static volatile uint8_t queue_tail;
+static volatile uint16_t overflows;
+
+// how far we are into a cursor key escape sequence (ESC [ x)
+static uint8_t characters_into_escape_sequence;
+
+static uint16_t latency[INPUT_NUM_SOURCES];
+static uint16_t max_latency[INPUT_NUM_SOURCES];
+
+void init_input(void) {
+	uint8_t i;
+	empty_input_queue();
+	overflows = 0;
+	for (i = 0; i < INPUT_NUM_SOURCES; i++) {
+		latency[i] = 0;
+		max_latency[i] = 0;
+	}
+}
+
+void empty_input_queue(void) {
+	// only the consumer's index moves, so this is safe with
+	// interrupts on
+	queue_tail = queue_head;
+}
+
+void add_input_event(InputSource source, InputType type, uint8_t value) {
+	uint8_t head = queue_head;
+	if ((uint8_t)(head - queue_tail) >= INPUT_QUEUE_SIZE) {
+		overflows++;
+		return;
+	}
+	InputEvent* event = &queue[head & INPUT_QUEUE_MASK];
+	event->source = source;
+	event->type = type;
+	event->value = value;
+	event->time = (uint16_t)get_clock_ticks();
+	// publish the event only once it is complete
+	memory_barrier();
+	queue_head = head + 1;
+}
+
+uint8_t get_input_event(InputEvent* event) {
+	uint8_t tail = queue_tail;
+	if (tail == queue_head) {
+		return 0;
+	}
+	*event = queue[tail & INPUT_QUEUE_MASK];
+	// hand the slot back to the producers once it has been copied
+	memory_barrier();
+	queue_tail = tail + 1;
+	
+	uint16_t waited = (uint16_t)get_clock_ticks() - event->time;
+	latency[event->source] = waited;
+	if (waited > max_latency[event->source]) {
+		max_latency[event->source] = waited;
+	}
+	return 1;
+}
+
+// called by the serial receive interrupt for each character while
+// serial input is being captured
+static void serial_input_to_event(char c) {
+	if (characters_into_escape_sequence == 0 && c == ESCAPE_CHAR) {
+		characters_into_escape_sequence++;
+	} else if (characters_into_escape_sequence == 1 && c == '[') {
+		characters_into_escape_sequence++;
+	} else if (characters_into_escape_sequence == 2) {
+		characters_into_escape_sequence = 0;
+		switch (c) {
+			case 'A': add_input_event(INPUT_SERIAL, INPUT_DIRECTION, SNAKE_UP); break;
+			case 'B': add_input_event(INPUT_SERIAL, INPUT_DIRECTION, SNAKE_DOWN); break;
+			case 'C': add_input_event(INPUT_SERIAL, INPUT_DIRECTION, SNAKE_RIGHT); break;
+			case 'D': add_input_event(INPUT_SERIAL, INPUT_DIRECTION, SNAKE_LEFT); break;
+		}
+	} else {
+		characters_into_escape_sequence = 0;
+		add_input_event(INPUT_SERIAL, INPUT_COMMAND, (uint8_t)c);
+	}
+}
+
+void capture_serial_input(uint8_t on) {
+	characters_into_escape_sequence = 0;
+	if (on) {
+		set_serial_input_handler(serial_input_to_event);
+	} else {
+		set_serial_input_handler(0);
+	}
+}
+
+uint16_t get_input_latency(InputSource source) {
+	return latency[source];
+}
+
+uint16_t get_input_max_latency(InputSource source) {
+	return max_latency[source];
+}
+
+uint16_t get_input_overflows(void) {
+	return overflows;
+}
@@ -0,0 +1,89 @@
+/*
+** input.h
+**
+** Written by Arda Akgur
+**
+** A single queue of timestamped input events from the push buttons,
+** the joystick and the serial port. Events are added by the interrupt
+** handlers (button pin change, ADC conversion complete and serial
+** receive) in the order they happen, and read by the game loop.
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include <inttypes.h>
+
+// Number of events the queue can hold - must be a power of two
+#define INPUT_QUEUE_SIZE 16
+
+// Where an event came from
+typedef enum {INPUT_BUTTON, INPUT_JOYSTICK, INPUT_SERIAL, INPUT_NUM_SOURCES} InputSource;
+
+// What an event is. For INPUT_DIRECTION the value is a SnakeDirnType,
+// for INPUT_COMMAND it is the character received over serial.
+typedef enum {INPUT_DIRECTION, INPUT_COMMAND} InputType;
+
+typedef struct {
+	uint8_t source;		// InputSource
+	uint8_t type;		// InputType
+	uint8_t value;
+	uint16_t time;		// clock ticks (ms) when captured, lower 16 bits
+} InputEvent;
+
+/* init_input()
+**
+** Empty the queue and reset the latency figures. Serial characters
+** are not captured until capture_serial_input(1) is called.
+*/
+void init_input(void);
+
+/* empty_input_queue()
+**
+** Discard any events waiting in the queue.
+*/
+void empty_input_queue(void);
+
+/* add_input_event(source, type, value)
+**
+** Add an event, timestamped with the current time, to the queue.
+** Must only be called with interrupts disabled (i.e. from an interrupt
+** handler) - the handlers can't interrupt each other so together they
+** are the single producer for the queue. If the queue is full the
+** event is dropped.
+*/
+void add_input_event(InputSource source, InputType type, uint8_t value);
+
+/* get_input_event(event)
+**
+** Remove the oldest event from the queue and copy it to *event.
+** Returns 1 if there was an event, 0 if the queue was empty. Must only
+** be called from the main program (the single consumer).
+*/
+uint8_t get_input_event(InputEvent* event);
+
+/* capture_serial_input(on)
+**
+** While on, characters received over serial are turned into events
+** (cursor key escape sequences become directions, anything else is a
+** command) instead of being buffered for stdin. Turn this off before
+** reading from stdin.
+*/
+void capture_serial_input(uint8_t on);
+
+/* get_input_latency(source) and get_input_max_latency(source)
+**
+** Time (ms) between capturing and reading the last event from the
+** given source, and the largest such time since init_input().
+*/
+uint16_t get_input_latency(InputSource source);
+uint16_t get_input_max_latency(InputSource source);
+
+/* get_input_overflows()
+**
+** Number of events dropped because the queue was full.
+*/
+uint16_t get_input_overflows(void);
+
+#endif
@@ -0,0 +1,321 @@
+/*
+** journal.c
+**
+** Written by Arda Akgur
+**
+** The journal region is split into JOURNAL_SLOT_SIZE byte slots. A
+** record starts at the beginning of a slot and takes as many slots as
+** it needs, running on from the last slot to the first if it has to.
+** A record is laid out as
+**   type, length, sequence number (2 bytes), header check,
+**   data (length bytes), CRC (2 bytes)
+** The header check is a CRC-8 of the four bytes before it, so a slot
+** can be ruled out without reading the whole record. The CRC at the
+** end is a CRC-16 of the type, length and data - it leaves out the
+** sequence number so a record can be copied forward (with a new
+** sequence number) straight from EEPROM to EEPROM.
+**
+** Slots from tail up to head hold records (current or not), the rest
+** are free. Before a record is added, records at the tail are freed
+** until there is room for it plus a spare record's worth: a record
+** that isn't current is just dropped, a current one is copied to the
+** head first. Each copy frees as many slots as it uses, and the spare
+** room means there is always space to make one, so as long as the
+** current records can't fill the journal this always finishes.
+*/
+
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "journal.h"
+#include "eeprom_layout.h"
+#include "eeprom_writer.h"
+
+#define JOURNAL_SLOT_SIZE 16
+#define JOURNAL_SLOTS (EEPROM_JOURNAL_SIZE / JOURNAL_SLOT_SIZE)
+
+#define HEADER_SIZE 5
+#define CRC_SIZE 2
+
+// Slots taken by a record with the given amount of data
+#define RECORD_SLOTS(length) \
+		(((length) + HEADER_SIZE + CRC_SIZE + JOURNAL_SLOT_SIZE - 1) / JOURNAL_SLOT_SIZE)
+#define MAX_RECORD_SLOTS RECORD_SLOTS(JOURNAL_MAX_DATA)
+
+// There must be room for one current record of every type, the record
+// being added and the spare
+_Static_assert(JOURNAL_TYPES * MAX_RECORD_SLOTS + 2 * MAX_RECORD_SLOTS <= JOURNAL_SLOTS,
+		"journal too small for its record types");
+
+#define NO_RECORD 0xFF
+
+// Number of records whose header and CRC can be waiting to be written
+#define PENDING_RECORDS 4
+
+// For each slot holding the start of a record between tail and head,
+// the number of slots the record takes, 0 for every other slot
+static uint8_t record_slots[JOURNAL_SLOTS];
+
+// First slot of the newest record of each type, or NO_RECORD
+static uint8_t current[JOURNAL_TYPES];
+
+// Data length of the newest record of each type, kept here so a record
+// can be copied without reading EEPROM while the writer is busy
+static uint8_t current_length[JOURNAL_TYPES];
+
+static uint8_t head;
+static uint8_t tail;
+static uint8_t used;
+static uint16_t next_sequence;
+
+// Header and CRC of records being written. A buffer is reused once
+// the record written from it four records ago is finished.
+typedef struct {
+	uint8_t header[HEADER_SIZE];
+	uint8_t crc[CRC_SIZE];
+} PendingRecord;
+static PendingRecord pending[PENDING_RECORDS];
+static uint8_t records_started;
+static volatile uint8_t records_finished;
+
+static JournalStats stats;
+
+// EEPROM address of a byte position within the journal
+static uint16_t journal_address(uint16_t position) {
+	return EEPROM_JOURNAL + position % EEPROM_JOURNAL_SIZE;
+}
+
+static uint8_t read_byte(uint16_t position) {
+	return eeprom_read_byte((const uint8_t*)journal_address(position));
+}
+
+static uint8_t header_check(const uint8_t* header) {
+	uint8_t crc = 0;
+	uint8_t i;
+	for (i = 0; i < HEADER_SIZE - 1; i++) {
+		crc = _crc8_ccitt_update(crc, header[i]);
+	}
+	return crc;
+}
+
+// Returns the number of slots taken by the valid record starting at
+// slot, or 0 if there isn't one. The sequence number goes in *sequence.
+static uint8_t check_record(uint8_t slot, uint16_t* sequence) {
+	uint16_t position = slot * JOURNAL_SLOT_SIZE;
+	uint8_t header[HEADER_SIZE];
+	uint16_t crc = 0xFFFF;
+	uint8_t i;
+	
+	eeprom_read_block(header, (const void*)journal_address(position), HEADER_SIZE);
+	if (header[0] >= JOURNAL_TYPES || header[1] > JOURNAL_MAX_DATA
+			|| header[4] != header_check(header)) {
+		return 0;
+	}
+	crc = _crc16_update(crc, header[0]);
+	crc = _crc16_update(crc, header[1]);
+	position += HEADER_SIZE;
+	for (i = 0; i < header[1]; i++) {
+		crc = _crc16_update(crc, read_byte(position++));
+	}
+	if (read_byte(position) != (crc & 0xFF) || read_byte(position + 1) != (crc >> 8)) {
+		return 0;
+	}
+	*sequence = header[2] | (header[3] << 8);
+	return RECORD_SLOTS(header[1]);
+}
+
+void init_journal(void) {
+	uint16_t sequence;
+	uint16_t newest_sequence[JOURNAL_TYPES];
+	uint16_t first_sequence = 0;
+	uint16_t last_sequence = 0;
+	uint8_t found = 0;
+	uint8_t slot, slots, type;
+	
+	for (type = 0; type < JOURNAL_TYPES; type++) {
+		current[type] = NO_RECORD;
+	}
+	head = 0;
+	tail = 0;
+	records_started = 0;
+	records_finished = 0;
+	slot = 0;
+	while (slot < JOURNAL_SLOTS) {
+		slots = check_record(slot, &sequence);
+		record_slots[slot] = slots;
+		if (!slots) {
+			slot++;
+			continue;
+		}
+		// sequence numbers wrap, so compare differences
+		type = read_byte(slot * JOURNAL_SLOT_SIZE);
+		if (current[type] == NO_RECORD || (int16_t)(sequence - newest_sequence[type]) > 0) {
+			current[type] = slot;
+			current_length[type] = read_byte(slot * JOURNAL_SLOT_SIZE + 1);
+			newest_sequence[type] = sequence;
+		}
+		if (!found || (int16_t)(sequence - first_sequence) < 0) {
+			first_sequence = sequence;
+			tail = slot;
+		}
+		if (!found || (int16_t)(sequence - last_sequence) > 0) {
+			last_sequence = sequence;
+			head = (slot + slots) % JOURNAL_SLOTS;
+		}
+		found = 1;
+		// slots inside a valid record can't start another one
+		for (slots--; slots > 0 && slot + 1 < JOURNAL_SLOTS; slots--) {
+			record_slots[++slot] = 0;
+		}
+		slot++;
+	}
+	used = (head + JOURNAL_SLOTS - tail) % JOURNAL_SLOTS;
+	if (found && used == 0) {
+		used = JOURNAL_SLOTS;
+	}
+	next_sequence = last_sequence + 1;
+	stats.slots = JOURNAL_SLOTS;
+}
+
+uint8_t read_journal(JournalType type, void* data, uint8_t length) {
+	uint16_t position;
+	uint8_t record_length;
+	uint8_t i;
+	if (current[type] == NO_RECORD) {
+		return 0;
+	}
+	while (is_eeprom_writing()) {
+		;
+	}
+	position = current[type] * JOURNAL_SLOT_SIZE;
+	record_length = read_byte(position + 1);
+	position += HEADER_SIZE;
+	for (i = 0; i < record_length && i < length; i++) {
+		((uint8_t*)data)[i] = read_byte(position + i);
+	}
+	return record_length;
+}
+
+static void record_finished(void) {
+	records_finished++;
+}
+
+// queues length bytes to be written at the given journal position,
+// from RAM or (if from_eeprom is set) from another journal position
+static void queue_write(uint16_t position, const uint8_t* data, uint16_t from,
+		uint8_t length, uint8_t from_eeprom, EepromDoneCallback done) {
+	uint8_t part;
+	position %= EEPROM_JOURNAL_SIZE;
+	from %= EEPROM_JOURNAL_SIZE;
+	while (length > 0) {
+		// split where either end runs off the end of the region
+		part = length;
+		if (position + part > EEPROM_JOURNAL_SIZE) {
+			part = EEPROM_JOURNAL_SIZE - position;
+		}
+		if (from_eeprom && from + part > EEPROM_JOURNAL_SIZE) {
+			part = EEPROM_JOURNAL_SIZE - from;
+		}
+		length -= part;
+		if (from_eeprom) {
+			while (!copy_eeprom_block(journal_address(position), journal_address(from),
+					part, length ? 0 : done)) {
+				;
+			}
+		} else {
+			while (!write_eeprom_block(journal_address(position), data, part,
+					length ? 0 : done)) {
+				;
+			}
+			data += part;
+		}
+		position = (position + part) % EEPROM_JOURNAL_SIZE;
+		from = (from + part) % EEPROM_JOURNAL_SIZE;
+	}
+}
+
+// Starts a record of the given type and length at the head and returns
+// the buffer for its header and CRC, with the header filled in.
+static PendingRecord* start_record(uint8_t type, uint8_t length) {
+	PendingRecord* record;
+	uint8_t slots = RECORD_SLOTS(length);
+	
+	while ((uint8_t)(records_started - records_finished) >= PENDING_RECORDS) {
+		;
+	}
+	record = &pending[records_started % PENDING_RECORDS];
+	records_started++;
+	record->header[0] = type;
+	record->header[1] = length;
+	record->header[2] = next_sequence & 0xFF;
+	record->header[3] = next_sequence >> 8;
+	record->header[4] = header_check(record->header);
+	next_sequence++;
+	
+	current[type] = head;
+	current_length[type] = length;
+	record_slots[head] = slots;
+	head = (head + slots) % JOURNAL_SLOTS;
+	used += slots;
+	stats.records++;
+	return record;
+}
+
+// frees the record (or unused slot) at the tail, copying it to the
+// head first if it is current
+static void free_tail(void) {
+	uint8_t slots = record_slots[tail];
+	uint8_t type;
+	uint8_t length;
+	uint16_t from;
+	PendingRecord* record;
+	
+	if (slots == 0) {
+		slots = 1;
+	} else {
+		for (type = 0; type < JOURNAL_TYPES; type++) {
+			if (current[type] == tail) {
+				from = tail * JOURNAL_SLOT_SIZE;
+				length = current_length[type];
+				record = start_record(type, length);
+				queue_write((uint16_t)current[type] * JOURNAL_SLOT_SIZE, record->header, 0,
+						HEADER_SIZE, 0, 0);
+				queue_write((uint16_t)current[type] * JOURNAL_SLOT_SIZE + HEADER_SIZE, 0,
+						from + HEADER_SIZE, length + CRC_SIZE, 1, record_finished);
+				stats.copies++;
+				break;
+			}
+		}
+		record_slots[tail] = 0;
+	}
+	tail = (tail + slots) % JOURNAL_SLOTS;
+	used -= slots;
+}
+
+void append_journal(JournalType type, const void* data, uint8_t length) {
+	PendingRecord* record;
+	uint16_t position;
+	uint16_t crc = 0xFFFF;
+	uint8_t i;
+	
+	while (JOURNAL_SLOTS - used < RECORD_SLOTS(length) + MAX_RECORD_SLOTS) {
+		free_tail();
+	}
+	
+	crc = _crc16_update(crc, type);
+	crc = _crc16_update(crc, length);
+	for (i = 0; i < length; i++) {
+		crc = _crc16_update(crc, ((const uint8_t*)data)[i]);
+	}
+	position = head * JOURNAL_SLOT_SIZE;
+	record = start_record(type, length);
+	record->crc[0] = crc & 0xFF;
+	record->crc[1] = crc >> 8;
+	queue_write(position, record->header, 0, HEADER_SIZE, 0, 0);
+	queue_write(position + HEADER_SIZE, data, 0, length, 0, 0);
+	queue_write(position + HEADER_SIZE + length, record->crc, 0, CRC_SIZE, 0, record_finished);
+}
+
+void get_journal_stats(JournalStats* journal_stats) {
+	stats.slots_used = used;
+	*journal_stats = stats;
+}
@@ -0,0 +1,78 @@
+/*
+** journal.h
+**
+** Written by Arda Akgur
+**
+** An append-only journal of small records in EEPROM, so that things
+** saved again and again (like the leaderboard) don't wear out the same
+** few cells. Each save adds a new record after the last one, going
+** round the journal's EEPROM region, and the newest valid record of
+** each type is the current one. A save is atomic: the old record stays
+** valid until the new one is completely written, and a record cut
+** short by a reset fails its CRC and is ignored.
+**
+** Records that are still current are copied forward before the
+** journal wraps round onto them, so every cell takes its share of the
+** writes no matter how often each type is saved.
+**
+** Writing is done in the background by the EEPROM writer (see
+** eeprom_writer.h).
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef JOURNAL_H_
+#define JOURNAL_H_
+
+#include <inttypes.h>
+
+// Record types. Only the newest record of each type is kept.
+typedef enum {
+	JOURNAL_LEADERBOARD,
+	JOURNAL_SNAPSHOT,
+	JOURNAL_TYPES
+} JournalType;
+
+// Longest record data
+#define JOURNAL_MAX_DATA 73
+
+// Records written (including copies) and records copied forward since
+// reset, and EEPROM slots in use now
+typedef struct {
+	uint16_t records;
+	uint16_t copies;
+	uint8_t slots_used;
+	uint8_t slots;
+} JournalStats;
+
+/* init_journal()
+**
+** Scan the journal for the newest record of each type. Call once at
+** boot, before anything else uses the EEPROM.
+*/
+void init_journal(void);
+
+/* read_journal(type, data, length)
+**
+** Copy up to length bytes of the newest record of the given type to
+** data. Returns the length of the record (which may be more than was
+** copied), or 0 if there isn't one. Waits for any EEPROM writing to
+** finish first.
+*/
+uint8_t read_journal(JournalType type, void* data, uint8_t length);
+
+/* append_journal(type, data, length)
+**
+** Start writing a new record of the given type with length (at most
+** JOURNAL_MAX_DATA) bytes from data. The data must not change until
+** is_eeprom_writing() returns 0. Only waits if the EEPROM writer's
+** queue is full.
+*/
+void append_journal(JournalType type, const void* data, uint8_t length);
+
+/* get_journal_stats(stats)
+**
+** Copy the counters into *stats.
+*/
+void get_journal_stats(JournalStats* stats);
+
+#endif
@@ -1,85 +1,116 @@
 /*
-** rat.c
-** Provides functionality of rat item in game
+** joystick.c
+** Interrupt driven joystick sampling
 ** Written by Arda Akgur
 */
 
-
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <stdint.h>
-#include <stdio.h>
 #include "joystick.h"
-#include "serialio.h"
+#include "input.h"
+#include "snake.h"
+
+// A direction is entered when one axis passes ENTER_HIGH/ENTER_LOW while
+// the other stays between ENTER_LOW and ENTER_HIGH. It is only released
+// when both axes are back between RELEASE_LOW and RELEASE_HIGH.
+#define ENTER_HIGH 600
+#define ENTER_LOW 400
+#define RELEASE_HIGH 550
+#define RELEASE_LOW 450
+
+#define NO_DIRECTION -1
+
+// Filter state, 4 times the filtered value for each axis. Each new
+// sample moves the value a quarter of the way towards it.
+static volatile uint16_t x_filter;
+static volatile uint16_t y_filter;
 
-// current x and y volt
-static uint16_t x;
-static uint16_t y;
+// direction the joystick is currently held in (or NO_DIRECTION)
+static volatile int8_t held_dirn;
 
-// returns x volt
+// reads a value shared with the ADC interrupt
+static uint16_t read_filter(volatile uint16_t* filter) {
+	uint8_t interrupts_were_on = bit_is_set(SREG, SREG_I);
+	cli();
+	uint16_t value = *filter;
+	if (interrupts_were_on) {
+		sei();
+	}
+	return value >> 2;
+}
+
+// returns filtered x volt
 uint16_t get_joystick_x(void) {
-	return x;
+	return read_filter(&x_filter);
 }
 
-// returns y volt
+// returns filtered y volt
 uint16_t get_joystick_y(void) {
-	return y;
+	return read_filter(&y_filter);
 }
 
 // returns true if currently there is joystick input
 uint8_t is_there_joystic_input(void) {
-	if (x < 550 && x > 450 && y < 550 && y > 450) {
-		return 0;
-	}
-	return 1;
+	return held_dirn != NO_DIRECTION;
 }
 
 // initiates jotstic 
 void init_joystic(void) {
-	// Set up ADC - AVCC reference, right adjust
-	// Input selection doesn't matter yet - we'll swap this around in the while
-	// loop below.
+	// Both axes start at the centre so we don't report a direction
+	// before the first samples arrive
+	x_filter = 512 << 2;
+	y_filter = 512 << 2;
+	held_dirn = NO_DIRECTION;
+	// Set up ADC - AVCC reference, right adjust, start with x (ADC0)
 	ADMUX = (1<<REFS0);
-	// Turn on the ADC (but don't start a conversion yet). Choose a clock
-	// divider of 64. (The ADC clock must be somewhere
-	// between 50kHz and 200kHz. We will divide our 8MHz clock by 64
-	// to give us 125kHz.)
-	ADCSRA = (1<<ADEN)|(1<<ADPS2)|(1<<ADPS1);
+	// Auto trigger on timer 0 compare match A (every millisecond)
+	ADCSRB = (1<<ADTS1)|(1<<ADTS0);
+	// Turn on the ADC with auto triggering and the conversion complete
+	// interrupt. Choose a clock divider of 64. (The ADC clock must be 
+	// somewhere between 50kHz and 200kHz. We will divide our 8MHz clock
+	// by 64 to give us 125kHz, so a conversion takes 104us.)
+	ADCSRA = (1<<ADEN)|(1<<ADATE)|(1<<ADIE)|(1<<ADPS2)|(1<<ADPS1);
 }
 
-// gets 2 loop and reads the currents
-// x and y ADC values, stores values
-// in memory
-void get_volt(void) {
-	DDRA = 0x00;
-	uint8_t counter = 2;
-	uint8_t x_or_y = 0;
-	uint16_t value;
-	while(counter > 0) {
-		// Set the ADC mux to choose ADC0 if x_or_y is 0, ADC1 if x_or_y is 1
-		if(x_or_y == 0) {
-			ADMUX &= ~1;
-			} else {
-			ADMUX |= 1;
-		}
-		// Start the ADC conversion
-		ADCSRA |= (1<<ADSC);
-		
-		while(ADCSRA & (1<<ADSC)) {
-			; /* Wait until conversion finished */
-		}
-		value = ADC; // read the value
-		if(x_or_y == 0) {
-			//printf("X: %4d ", value);
-			x = value;
-			} else {
-			//printf("Y: %4d\n", value);
-			y = value;
-		}
-		// Next time through the loop, do the other direction
-		x_or_y ^= 1;
-		counter--;
+// works out the direction from the filtered values, including
+// the hysteresis on the held direction
+static int8_t classify(uint16_t x, uint16_t y) {
+	uint8_t x_centred = (x >= ENTER_LOW && x < ENTER_HIGH);
+	uint8_t y_centred = (y >= ENTER_LOW && y < ENTER_HIGH);
+	if (y >= ENTER_HIGH && x_centred) {
+		return SNAKE_LEFT;
+	} else if (y < ENTER_LOW && x_centred) {
+		return SNAKE_RIGHT;
+	} else if (x >= ENTER_HIGH && y_centred) {
+		return SNAKE_UP;
+	} else if (x < ENTER_LOW && y_centred) {
+		return SNAKE_DOWN;
+	} else if (x > RELEASE_LOW && x < RELEASE_HIGH && y > RELEASE_LOW && y < RELEASE_HIGH) {
+		return NO_DIRECTION;
 	}
+	// between the thresholds - keep what we had
+	return held_dirn;
 }
 
-
+// Conversion complete. The next conversion won't start until the next
+// timer 0 compare match, so switching the channel here takes effect
+// on that conversion.
+ISR(ADC_vect) {
+	uint16_t value = ADC;
+	if (ADMUX & 1) {
+		y_filter += value - (y_filter >> 2);
+		ADMUX &= ~1;
+		// both axes have a fresh sample - check for a new direction
+		int8_t dirn = classify(x_filter >> 2, y_filter >> 2);
+		if (dirn != held_dirn) {
+			held_dirn = dirn;
+			if (dirn != NO_DIRECTION) {
+				add_input_event(INPUT_JOYSTICK, INPUT_DIRECTION, dirn);
+			}
+		}
+	} else {
+		x_filter += value - (x_filter >> 2);
+		ADMUX |= 1;
+	}
+}
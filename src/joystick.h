@@ -3,21 +3,29 @@
 **
 ** Written by Arda Akgur
 **
-** Function prototypes for joystick usage
+** Function prototypes for joystick usage. The joystick is sampled in
+** the background by the ADC interrupt - the ADC is auto-triggered by
+** the timer 0 compare match every millisecond and alternates between
+** the x (ADC0) and y (ADC1) channels, so each axis is sampled every
+** 2ms. Readings are filtered and turned into direction events with
+** hysteresis. Directions are added to the input event queue (see
+** input.h), so callers never wait on a conversion.
 */
 #ifndef JOYSTICK_H_
 #define JOYSTICK_H_
 
-void init_joystic(void);
+#include <stdint.h>
 
-void get_volt(void);
+// Set up the ADC for interrupt driven sampling. Sampling starts once
+// timer 0 is running and interrupts are enabled.
+void init_joystic(void);
 
+// Filtered x and y readings (0 to 1023, centre around 512)
 uint16_t get_joystick_x(void);
 
 uint16_t get_joystick_y(void);
 
+// returns 1 while the joystick is pushed in some direction
 uint8_t is_there_joystic_input(void);
 
-
-
 #endif
@@ -0,0 +1,338 @@
+/*
+** leaderboard.c
+**
+** Written by Arda Akgur
+**
+** Each entry takes a SLOT_SIZE byte slot in the EEPROM leaderboard
+** region: the name packed 6 bits a character, then the score. There
+** is one more slot than entries, so a new entry is always written to
+** a slot the saved table doesn't use. The journal record then lists
+** the slot of each rank, best first, and saving it is what makes the
+** new entry part of the table - if the power goes before then, the
+** old table is still there as it was.
+**
+** Adding an entry writes one slot and one journal record, however
+** many entries it pushes down. Ranks are found with a binary search
+** of the scores, which are read from the RAM cache for the shown
+** entries and from EEPROM for the rest.
+*/
+
+#include <string.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include "leaderboard.h"
+#include "journal.h"
+#include "eeprom_layout.h"
+#include "eeprom_writer.h"
+
+// Bump this when the record or slot layout changes
+#define LEADERBOARD_VERSION 2
+
+// name characters are packed 6 bits each, 0 marks the end
+#define PACKED_NAME_SIZE ((LEADER_NAME_LENGTH * 6 + 7) / 8)
+#define SLOT_SIZE (PACKED_NAME_SIZE + 2)
+#define NUM_SLOTS (LEADERBOARD_SIZE + 1)
+
+#define CODE_SPACE 63
+
+_Static_assert(NUM_SLOTS * SLOT_SIZE <= EEPROM_LEADERBOARD_SIZE,
+		"leaderboard slots don't fit their EEPROM space");
+
+typedef struct {
+	uint8_t version;
+	uint8_t count;
+	uint8_t slots[LEADERBOARD_SIZE];
+} LeaderboardRecord;
+
+_Static_assert(sizeof(LeaderboardRecord) <= JOURNAL_MAX_DATA,
+		"leaderboard record doesn't fit in a journal record");
+
+typedef struct {
+	char name[LEADER_NAME_LENGTH + 1];
+	uint16_t score;
+} LeaderEntry;
+
+static LeaderboardRecord record;
+
+// the shown entries
+static LeaderEntry shown[LEADERBOARD_SHOWN];
+
+// slot being written, and name read for get_leader_name()
+static uint8_t slot_data[SLOT_SIZE];
+static char name_buffer[LEADER_NAME_LENGTH + 1];
+
+// how far reading the table has got, see step_leaderboard()
+typedef enum {
+	LOAD_IDLE,		// not asked for yet
+	LOAD_RECORD,	// read the journal record next
+	LOAD_ENTRIES,	// read the shown entry at load_rank next
+	LOAD_DEFAULTS,	// write the default entry at load_rank next
+	LOAD_DONE		// the table can be used
+} LoadState;
+
+static uint8_t load_state = LOAD_IDLE;
+static uint8_t load_rank;
+
+// table used when there isn't a valid one saved
+static const LeaderEntry default_entries[LEADERBOARD_SHOWN] PROGMEM = {
+	{"AAA", 500}, {"BBB", 400}, {"CCC", 300}, {"DDD", 200}, {"EEE", 50}
+};
+
+static uint8_t encode_char(char c) {
+	if (c >= 'A' && c <= 'Z') {
+		return c - 'A' + 1;
+	} else if (c >= 'a' && c <= 'z') {
+		return c - 'a' + 27;
+	} else if (c >= '0' && c <= '9') {
+		return c - '0' + 53;
+	}
+	return CODE_SPACE;
+}
+
+static char decode_char(uint8_t code) {
+	if (code <= 26) {
+		return code - 1 + 'A';
+	} else if (code <= 52) {
+		return code - 27 + 'a';
+	} else if (code <= 62) {
+		return code - 53 + '0';
+	}
+	return ' ';
+}
+
+// copies the name as it will be read back from its slot
+static void copy_name(char* to, const char* from) {
+	uint8_t i;
+	for (i = 0; i < LEADER_NAME_LENGTH && from[i]; i++) {
+		to[i] = decode_char(encode_char(from[i]));
+	}
+	to[i] = 0;
+}
+
+// packs the name and score into slot_data
+static void pack_entry(const char* name, uint16_t score) {
+	uint16_t bits = 0;
+	uint8_t num_bits = 0;
+	uint8_t out = 0;
+	uint8_t i;
+	for (i = 0; i < LEADER_NAME_LENGTH; i++) {
+		bits = (bits << 6) | (*name ? encode_char(*name++) : 0);
+		num_bits += 6;
+		if (num_bits >= 8) {
+			num_bits -= 8;
+			slot_data[out++] = bits >> num_bits;
+		}
+	}
+	if (num_bits) {
+		slot_data[out] = bits << (8 - num_bits);
+	}
+	slot_data[PACKED_NAME_SIZE] = score & 0xFF;
+	slot_data[PACKED_NAME_SIZE + 1] = score >> 8;
+}
+
+static uint16_t slot_address(uint8_t slot) {
+	return EEPROM_LEADERBOARD + slot * SLOT_SIZE;
+}
+
+// reads the name in the slot into name
+static void read_name(uint8_t slot, char* name) {
+	uint8_t packed[PACKED_NAME_SIZE];
+	uint16_t bits = 0;
+	uint8_t num_bits = 0;
+	uint8_t in = 0;
+	uint8_t i;
+	// reading while the writer is busy could clash with it
+	while (is_eeprom_writing()) {
+		;
+	}
+	eeprom_read_block(packed, (const void*)slot_address(slot), PACKED_NAME_SIZE);
+	for (i = 0; i < LEADER_NAME_LENGTH; i++) {
+		if (num_bits < 6) {
+			bits = (bits << 8) | packed[in++];
+			num_bits += 8;
+		}
+		num_bits -= 6;
+		if (((bits >> num_bits) & 0x3F) == 0) {
+			break;
+		}
+		name[i] = decode_char((bits >> num_bits) & 0x3F);
+	}
+	name[i] = 0;
+}
+
+static uint16_t read_score(uint8_t slot) {
+	while (is_eeprom_writing()) {
+		;
+	}
+	return eeprom_read_word((const uint16_t*)(slot_address(slot) + PACKED_NAME_SIZE));
+}
+
+// writes the entry to the slot, waiting until the last slot written is
+// finished first
+static void write_entry(uint8_t slot, const char* name, uint16_t score) {
+	while (is_eeprom_writing()) {
+		;
+	}
+	pack_entry(name, score);
+	while (!write_eeprom_block(slot_address(slot), slot_data, SLOT_SIZE, 0)) {
+		;
+	}
+}
+
+// returns a slot not used by the table
+static uint8_t find_spare_slot(void) {
+	uint8_t used[(NUM_SLOTS + 7) / 8];
+	uint8_t i;
+	memset(used, 0, sizeof(used));
+	for (i = 0; i < record.count; i++) {
+		used[record.slots[i] / 8] |= 1 << (record.slots[i] % 8);
+	}
+	for (i = 0; used[i / 8] & (1 << (i % 8)); i++) {
+		;
+	}
+	return i;
+}
+
+void start_leaderboard_load(void) {
+	if (load_state == LOAD_IDLE) {
+		load_state = LOAD_RECORD;
+	}
+}
+
+void step_leaderboard(void) {
+	// every step reads or writes the EEPROM, which would have to wait
+	// for the writer if it were busy
+	if (load_state == LOAD_IDLE || load_state == LOAD_DONE || is_eeprom_writing()) {
+		return;
+	}
+	switch (load_state) {
+		case LOAD_RECORD:
+			load_rank = 0;
+			if (read_journal(JOURNAL_LEADERBOARD, &record, sizeof(record)) != sizeof(record)
+					|| record.version != LEADERBOARD_VERSION
+					|| record.count > LEADERBOARD_SIZE) {
+				// a new table of the default entries, in their own slots
+				record.version = LEADERBOARD_VERSION;
+				record.count = LEADERBOARD_SHOWN;
+				memcpy_P(shown, default_entries, sizeof(shown));
+				load_state = LOAD_DEFAULTS;
+			} else {
+				load_state = record.count ? LOAD_ENTRIES : LOAD_DONE;
+			}
+			break;
+		case LOAD_ENTRIES:
+			read_name(record.slots[load_rank], shown[load_rank].name);
+			shown[load_rank].score = read_score(record.slots[load_rank]);
+			load_rank++;
+			if (load_rank >= LEADERBOARD_SHOWN || load_rank >= record.count) {
+				load_state = LOAD_DONE;
+			}
+			break;
+		case LOAD_DEFAULTS:
+			record.slots[load_rank] = load_rank;
+			write_entry(load_rank, shown[load_rank].name, shown[load_rank].score);
+			load_rank++;
+			if (load_rank >= LEADERBOARD_SHOWN) {
+				load_state = LOAD_DONE;
+				save_leaderboard();
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+uint8_t is_leaderboard_loaded(void) {
+	return load_state == LOAD_DONE;
+}
+
+// finishes reading the table, waiting for the EEPROM writer as needed
+static void load_leaderboard(void) {
+	start_leaderboard_load();
+	while (load_state != LOAD_DONE) {
+		step_leaderboard();
+	}
+}
+
+void save_leaderboard(void) {
+	if (load_state != LOAD_DONE) {
+		load_leaderboard();
+	}
+	append_journal(JOURNAL_LEADERBOARD, &record, sizeof(record));
+}
+
+int8_t get_leaderboard_rank(uint16_t score) {
+	// first rank with a lower score, below any with the same score
+	uint8_t low = 0;
+	uint8_t high;
+	if (load_state != LOAD_DONE) {
+		load_leaderboard();
+	}
+	high = record.count;
+	while (low < high) {
+		uint8_t middle = (low + high) / 2;
+		if (score > get_leader_score(middle)) {
+			high = middle;
+		} else {
+			low = middle + 1;
+		}
+	}
+	if (low >= LEADERBOARD_SIZE) {
+		return -1;
+	}
+	return low;
+}
+
+void add_to_leaderboard(const char* name, uint16_t score) {
+	int8_t rank = get_leaderboard_rank(score);
+	uint8_t slot;
+	uint8_t i;
+	if (rank < 0) {
+		return;
+	}
+	slot = find_spare_slot();
+	write_entry(slot, name, score);
+	// the last entry falls off the end if the table is full
+	if (record.count < LEADERBOARD_SIZE) {
+		record.count++;
+	}
+	for (i = record.count - 1; i > rank; i--) {
+		record.slots[i] = record.slots[i - 1];
+	}
+	record.slots[rank] = slot;
+	if (rank < LEADERBOARD_SHOWN) {
+		for (i = LEADERBOARD_SHOWN - 1; i > rank; i--) {
+			shown[i] = shown[i - 1];
+		}
+		copy_name(shown[rank].name, name);
+		shown[rank].score = score;
+	}
+}
+
+uint8_t get_leaderboard_count(void) {
+	if (load_state != LOAD_DONE) {
+		load_leaderboard();
+	}
+	return record.count;
+}
+
+const char* get_leader_name(uint8_t rank) {
+	if (load_state != LOAD_DONE) {
+		load_leaderboard();
+	}
+	if (rank < LEADERBOARD_SHOWN) {
+		return shown[rank].name;
+	}
+	read_name(record.slots[rank], name_buffer);
+	return name_buffer;
+}
+
+uint16_t get_leader_score(uint8_t rank) {
+	if (load_state != LOAD_DONE) {
+		load_leaderboard();
+	}
+	if (rank < LEADERBOARD_SHOWN) {
+		return shown[rank].score;
+	}
+	return read_score(record.slots[rank]);
+}
@@ -0,0 +1,101 @@
+/*
+** leaderboard.h
+**
+** Written by Arda Akgur
+**
+** The high score table. Entries live in EEPROM slots and a record of
+** which slot holds each rank is saved to the EEPROM journal (see
+** journal.h) with a version number, so a table that was never saved,
+** was only partly written or was saved by an older version of the
+** game is recognised and replaced with the default one. Only the
+** entries shown on screen are kept in RAM, and they aren't read until
+** the table is first used. init_journal() must be called before that.
+**
+** The table can be read a step at a time from the main loop, so the
+** game doesn't stall on it (see step_leaderboard()). Any of the other
+** functions finish reading it first if that hasn't been done, waiting
+** for the EEPROM writer as needed.
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef LEADERBOARD_H_
+#define LEADERBOARD_H_
+
+#include <inttypes.h>
+
+// Number of entries in the table
+#define LEADERBOARD_SIZE 50
+
+// Number of entries at the top of the table that are shown, and kept
+// in RAM
+#define LEADERBOARD_SHOWN 5
+
+// Longest name kept, longer names are cut short. Names can have
+// letters, digits and spaces, anything else becomes a space.
+#define LEADER_NAME_LENGTH 9
+
+/* start_leaderboard_load()
+**
+** Start reading the table in the background. Does nothing if that
+** has already been started.
+*/
+void start_leaderboard_load(void);
+
+/* step_leaderboard()
+**
+** Do the next part of reading the table (or of writing the default
+** table if there isn't a valid one saved), once
+** start_leaderboard_load() has been called. Does nothing while the
+** EEPROM writer is busy, so it never waits. Call from the main loop.
+*/
+void step_leaderboard(void);
+
+/* is_leaderboard_loaded()
+**
+** Returns 1 once the table has been read, so using it won't wait.
+*/
+uint8_t is_leaderboard_loaded(void);
+
+/* save_leaderboard()
+**
+** Start writing the table to a new journal record in the background.
+** The table must not be changed until is_eeprom_writing() returns 0.
+*/
+void save_leaderboard(void);
+
+/* get_leaderboard_rank(score)
+**
+** Returns the rank (0 is the best) the score would get in the table,
+** or -1 if it doesn't beat any entry and the table is full.
+*/
+int8_t get_leaderboard_rank(uint16_t score);
+
+/* add_to_leaderboard(name, score)
+**
+** Add an entry if the score ranks, the last entry falls off the end
+** if the table is full. The entry is written to a spare EEPROM slot
+** straight away but isn't part of the saved table until
+** save_leaderboard() is called.
+*/
+void add_to_leaderboard(const char* name, uint16_t score);
+
+/* get_leaderboard_count()
+**
+** Returns the number of entries in the table.
+*/
+uint8_t get_leaderboard_count(void);
+
+/* get_leader_name(rank)
+**
+** Returns the name at the given rank. Names below the shown entries
+** are read from EEPROM into a buffer that is reused by the next call.
+*/
+const char* get_leader_name(uint8_t rank);
+
+/* get_leader_score(rank)
+**
+** Returns the score at the given rank.
+*/
+uint16_t get_leader_score(uint8_t rank);
+
+#endif
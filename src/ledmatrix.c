@@ -6,7 +6,6 @@
  * See the LED matrix Reference for details of the SPI commands used.
  */ 
 
-#include <avr/io.h>
 #include "ledmatrix.h"
 #include "spi.h"
 
@@ -0,0 +1,47 @@
+/*
+** prng.c
+**
+** Written by Arda Akgur
+**
+** xorshift with shifts of 7, 9 and 8 goes through every 16 bit value
+** but 0 before repeating. The shifts by 8 are just byte moves on the
+** AVR, so a draw is a couple of dozen instructions with no division -
+** random() from avr-libc does 32 bit divisions for each one.
+*/
+
+#include <avr/io.h>
+#include "prng.h"
+
+static uint16_t state = 1;
+
+// moves the state on and returns it
+static uint16_t next_prng(void) {
+	state ^= state << 7;
+	state ^= state >> 9;
+	state ^= state << 8;
+	return state;
+}
+
+void init_prng(void) {
+	// the low bits of both are the noisy ones
+	set_prng_state(ADC ^ (TCNT1 << 6) ^ TCNT1);
+	next_prng();
+}
+
+void stir_prng(uint16_t value) {
+	set_prng_state(state ^ value);
+	next_prng();
+}
+
+uint16_t get_prng_state(void) {
+	return state;
+}
+
+void set_prng_state(uint16_t new_state) {
+	state = new_state ? new_state : 1;
+}
+
+uint8_t random_below(uint8_t n) {
+	// scale the top byte rather than use % so there's no division
+	return ((next_prng() >> 8) * n) >> 8;
+}
@@ -0,0 +1,49 @@
+/*
+** prng.h
+**
+** Written by Arda Akgur
+**
+** The random number generator used for every random choice in the
+** game - where food, rats and super food appear, which way the rat
+** steps and the splash screen colours. It is a 16 bit xorshift
+** generator, so its whole state is one word that can be saved with a
+** snapshot or a replay, and the same state always gives the same
+** choices.
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef PRNG_H_
+#define PRNG_H_
+
+#include <inttypes.h>
+
+/* init_prng()
+**
+** Seed the generator from the joystick ADC reading and timer 1, which
+** has been counting since reset (see boot_profile.h). Should be called
+** once the joystick has been set up and interrupts are on.
+*/
+void init_prng(void);
+
+/* stir_prng(value)
+**
+** Mix something unpredictable (e.g. the time a button was pressed)
+** into the state.
+*/
+void stir_prng(uint16_t value);
+
+/* get_prng_state() and set_prng_state(state)
+**
+** Read or set the whole state of the generator. A state of 0 is
+** changed to 1, as xorshift never leaves 0.
+*/
+uint16_t get_prng_state(void);
+void set_prng_state(uint16_t state);
+
+/* random_below(n)
+**
+** Returns a random number from 0 to n - 1.
+*/
+uint8_t random_below(uint8_t n);
+
+#endif
@@ -10,8 +10,6 @@
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
 #include <stdio.h>
-#include <stdlib.h>		// For random()
-#include <avr/eeprom.h>
 #include <string.h>
 #include "ledmatrix.h"
 #include "scrolling_char_display.h"
@@ -29,12 +27,30 @@
 #include "board.h"
 #include "joystick.h"
 #include "tron.h"
+#include "animation.h"
+#include "input.h"
+#include "terminal_view.h"
+#include "baud.h"
+#include "telemetry.h"
+#include "channel.h"
+#include "console.h"
+#include "leaderboard.h"
+#include "journal.h"
+#include "snapshot.h"
+#include "game_record.h"
+#include "boot_profile.h"
+#include "replay.h"
+#include "prng.h"
+#include "state_hash.h"
 
 // Define the CPU clock speed so we can use library delay functions
 #define F_CPU 8000000L
 
 #include <util/delay.h>
 
+// Super food blinks for this long (ms) before it goes
+#define SUPER_FOOD_BLINK_TIME 1000
+
 // Function prototypes - these are defined below (after main()) in the order
 // given here
 void initialise_hardware(void);
@@ -43,27 +59,19 @@ void new_game(void);
 void play_game(void);
 void handle_game_over(void);
 void handle_new_lap(void);
-void print_grid(void);
-
 
-// ASCII code for Escape character
-#define ESCAPE_CHAR 27
 
 // seven segment display characters
 uint8_t seven_seg[10] = { 63,6,91,79,102,109,125,7,127,111};
 
-// control character for EEPROM
-uint8_t control_character = 65;
-uint8_t load_control = (uint8_t) '@';
+// set if a saved game is waiting to be loaded
 uint8_t load = 0;
 
-// is currently we have saved leader boards
-uint8_t old_player = 0;
+// set if a button was held down at reset, to skip the splash screen
+uint8_t fast_start = 0;
 
-// for storing names and scores
-// after reading from ROM
-char** player_names;
-uint16_t* player_scores;
+// cleared if a replay didn't end the same way as the game it replayed
+uint8_t replay_in_sync = 1;
 
 
 // Helper function
@@ -71,69 +79,41 @@ static void update_display_at_position(PosnType posn, PixelColour colour) {
 	ledmatrix_update_pixel(x_position(posn), y_position(posn), colour);
 }
 
-static void check_old_player(void) {
-	uint8_t byteRead = eeprom_read_byte((uint8_t*)90);
-	if (byteRead == control_character) {
-		old_player = 1;
-	}
-	byteRead = eeprom_read_byte((uint8_t*)253);
-	if (byteRead == load_control) {
-		load = 1;
-	}
-}
-
-static void read_high_scores(void) {
-	uint8_t total = eeprom_read_byte((uint8_t*)89);
-	char buffer[total];
-	uint8_t i;
-	uint8_t j = 9;
-	uint8_t index = 0;
-	uint8_t* pos = (uint8_t*) 91;
-	for (i = 0; i < total; i++) {
-		buffer[i] = eeprom_read_byte(pos);
-		pos++;
-	}
-	for (i = 0; i < strlen(buffer); i++) {
-		if (buffer[i] != ':') {
-			player_names[index][j] = buffer[i];
-			j++;
-		} else {
-			j = 0;
-			index++;
-		}
-		
-	}
-	player_scores[0] = eeprom_read_word((uint16_t*)300);
-	player_scores[1] = eeprom_read_word((uint16_t*)302);
-	player_scores[2] = eeprom_read_word((uint16_t*)304);
-	player_scores[3] = eeprom_read_word((uint16_t*)306);
-	player_scores[4] = eeprom_read_word((uint16_t*)308);
-	
-} 
-
 /////////////////////////////// main //////////////////////////////////
 int main(void) {
+	mark_boot_stage(BOOT_MAIN);
 	// Setup hardware and call backs. This will turn on 
 	// interrupts.
+	init_input();
 	init_joystic();
 	initialise_hardware();
-	check_old_player();
-	if (old_player) {
-		player_names = malloc(sizeof(char*) * 5);
-		uint8_t i = 0;
-		for (i = 0; i < 5; i++) {
-			player_names[i] = malloc(sizeof(char) * 10);
-		}
-		player_scores = malloc(sizeof(uint8_t) * 5);
-		read_high_scores();
-	}
-	// Show the splash screen message. Returns when display
+	mark_boot_stage(BOOT_HARDWARE);
+	init_prng();
+	fast_start = read_buttons() != 0;
+	// the leaderboard isn't read until the game is running
+	init_journal();
+	load = is_snapshot_saved();
+	mark_boot_stage(BOOT_JOURNAL);
+	// Show the splash screen message, unless we're carrying on a
+	// saved game or a button is held down. Returns when display
 	// is complete
-	splash_screen();
+	if (!load && !fast_start) {
+		splash_screen();
+	}
+	mark_boot_stage(BOOT_SPLASH);
 	while(1) {
 		new_game();
 		play_game();
-		handle_game_over();
+		// a replay asked for from the console starts straight away
+		if (get_replay_request()) {
+			if (is_tron_mode()) {
+				clear_tron();
+				set_tron_mode(0);
+			}
+			start_replay(get_replay_request());
+		} else {
+			handle_game_over();
+		}
 	}
 }
 
@@ -150,6 +130,8 @@ void initialise_hardware(void) {
 	// Setup serial port for 19200 baud communication with no echo
 	// of incoming characters
 	init_serial_stdio(19200, 0);
+	// unframed to start with, the host can turn framing on
+	init_channels();
 	
 	// Set up our main timer to give us an interrupt every millisecond
 	init_timer0();
@@ -179,21 +161,21 @@ void splash_screen(void) {
 	
 	// Red message the first time through
 	PixelColour colour = COLOUR_ARC;
+	InputEvent event;
 	while(1) {
 		set_scrolling_display_text("43829114", colour);
 		// Scroll the message until it has scrolled off the 
 		// display or a button is pushed. We pause for 130ms between each scroll.
 		while(scroll_display()) {
 			_delay_ms(130);
-			get_volt();
-			if(is_there_joystic_input() ||button_pushed() != -1 ) {
-				// A button has been pushed
+			if(get_input_event(&event)) {
+				// A button has been pushed or the joystick moved
 				return;
 			}
 		}
 		// Message has scrolled off the display. Change colour
 		// to a random colour and scroll again.
-		switch(random() % 4) {
+		switch(random_below(4)) {
 			case 0: colour = COLOUR_LIGHT_ORANGE; break;
 			case 1: colour = COLOUR_RED; break;
 			case 2: colour = COLOUR_YELLOW; break;
@@ -206,6 +188,15 @@ void new_game(void) {
 	// Clear the serial terminal
 	clear_terminal();
 	
+	// A replay starts from the same random state as the game it
+	// replays. Otherwise when the button was pressed is stirred in.
+	if (is_replaying()) {
+		set_prng_state(get_replay_seed());
+	} else {
+		stir_prng(get_clock_ticks());
+		start_recording(get_prng_state());
+	}
+	
 	// Initialise the game and display
 	init_game();
 		
@@ -213,31 +204,72 @@ void new_game(void) {
 	init_score();
 	
 	// Delete any pending button pushes or serial input
-	empty_button_queue();
+	empty_input_queue();
 	clear_serial_input_buffer();
 }
 
+// Shows line number rank (0 is the best) of the high scores in the
+// console area of the terminal. Returns 0 if there wasn't room for it.
+static uint8_t show_high_score(uint8_t rank) {
+	char line[CONSOLE_LINE_SIZE + 1];
+	snprintf_P(line, sizeof(line), PSTR("%d %s - %u"), rank + 1,
+			get_leader_name(rank), get_leader_score(rank));
+	return console_print(line);
+}
+
+// Applies a direction change or Tron toggle (see replay.h), from the
+// player or from a replay
+static void apply_game_event(uint8_t game_event) {
+	if (game_event == REPLAY_TRON) {
+		if (!is_tron_mode()) {
+			init_tron();
+			update_display_at_position(get_tron_head_position(), COLOUR_ARC);
+			update_display_at_position(get_tron_tail_position(), COLOUR_RED);
+			set_tron_mode(1);
+		} else {
+			clear_tron();
+			set_tron_mode(0);
+		}
+	} else if (game_event == REPLAY_SETTING) {
+		uint16_t value;
+		uint8_t setting = get_replay_setting(&value);
+		set_game_setting(setting, value);
+	} else {
+		set_snake_dirn(game_event);
+	}
+}
+
 void play_game(void) {
-	// for time based events
+	// for time based events, the clock for the display and game time
+	// (see game.h) for the game
 	uint32_t last_print_time;
 	uint32_t last_move_time;
 	uint32_t rat_last_move_time;
 	uint32_t last_len_time;
-	uint32_t pause_time;
+	uint32_t last_clock;
+	uint32_t now;
+	uint32_t game_time;
+	uint32_t target_time;
+	uint16_t move_time;
 	
-	// forbutton and serial in
-	int8_t button;
-	char serial_input, escape_sequence_char;
-	uint8_t characters_into_escape_sequence = 0;
+	// for button, joystick and serial in
+	InputEvent event;
+	int8_t replay_event;
 	
 	// for flow of control
 	uint8_t pause = 0;
 	uint8_t control = 0;
-	uint8_t ignore = 0;
+	uint8_t over = 0;
+	
+	// game time goes this many times faster than the clock
+	uint8_t speed = is_replaying() ? get_replay_speed() : 1;
 	
-	// for joystick movement
-	uint16_t joystick_x;
-	uint16_t joystick_y;
+	// game speed in hundredths for the log, which can't print floats
+	uint16_t start_speed = get_game_speed() * 100 + 0.5;
+	
+	// next high score line to show after H, LEADERBOARD_SHOWN once
+	// they're all shown
+	uint8_t next_high_score = LEADERBOARD_SHOWN;
 	
 	// DDRC 255 for displaying seven segment 
 	DDRC = 0xFF;
@@ -250,156 +282,227 @@ void play_game(void) {
 	// Record the last time the snake moved as the current time -
 	// this ensures we don't move the snake immediately.
 	// Also record rest of the time variables
-	last_move_time = get_clock_ticks();
-	rat_last_move_time = get_clock_ticks();
+	last_move_time = get_game_time();
+	rat_last_move_time = get_game_time();
 	last_print_time = get_clock_ticks();
 	last_len_time = get_clock_ticks();
+	
+	// carry on from the game saved when it was paused, if there is one,
+	// still paused. It didn't start from its seed so it can't be
+	// replayed.
+	if (load) {
+		load = 0;
+		if (load_snapshot(&last_move_time, &rat_last_move_time)) {
+			redraw_game();
+			pause = 1;
+			cancel_recording();
+		}
+	}
+	
+	// draw the border and labels, the rest is drawn as it changes -
+	// and/or if telemetry is on, send the board to the host
+	if (is_terminal_view_shown()) {
+		init_terminal_view();
+	}
+	init_console();
+	start_telemetry();
+	log_P(PSTR("game start speed %u.%02u"), start_speed / 100, start_speed % 100);
+	if (is_replaying()) {
+		log_P(PSTR("replay at %dx"), speed);
+	}
+	
+	// serial characters become input events while we play
+	capture_serial_input(1);
+	if (!is_replaying()) {
+		start_game_record();
+	}
+	last_clock = get_clock_ticks();
+	// the first game after reset is playable from here
+	mark_boot_stage(BOOT_PLAYING);
+	// read the leaderboard while we play, for H and the game over
+	start_leaderboard_load();
 
 	while(1) {
-		//initiate inputs, serial, button and joystic
-		serial_input = -1;
-		escape_sequence_char = -1;
-		button = button_pushed();
-		get_volt();
-		
-		// first check joystick input since it should override any other
-		if (is_there_joystic_input()) {
-			joystick_x = get_joystick_x();
-			joystick_y = get_joystick_y();
-			if (joystick_y >= 600 && joystick_x < 600 && joystick_x >= 400) {
-				set_snake_dirn(SNAKE_LEFT);
-			}
-			if (joystick_y < 400 && joystick_x < 600 && joystick_x >= 400) {
+		// handle buttons, joystick and serial input in the order
+		// they happened
+		while (get_input_event(&event)) {
+			if (event.type == INPUT_DIRECTION) {
+				// the player's moves are recorded at the game time they
+				// happen, a replay ignores them
+				if (!is_replaying()) {
+					apply_game_event(event.value);
+					record_event(get_game_time(), event.value);
+				}
 				
-				set_snake_dirn(SNAKE_RIGHT);
-			}
-			if (joystick_x >= 600 && joystick_y < 600 && joystick_y >= 400) {
+				// a console command being typed
+			} else if (is_terminal_view_shown() && handle_console_input(event.value)) {
 				
-				set_snake_dirn(SNAKE_UP);
-			}
-			if (joystick_x <400 && joystick_y < 600 && joystick_y >= 400) {
+				// the host asking for a different baud rate
+			} else if (handle_baud_input(event.value)) {
 				
-				set_snake_dirn(SNAKE_DOWN);
+				// if P pressed Pause
+			} else if (event.value == 'p' || event.value == 'P') {
+				// the game is saved while paused, in case the power goes,
+				// but not a replay. Game time stops while paused.
+				pause = !pause;
+				if (!is_replaying()) {
+					if (pause) {
+						save_snapshot(last_move_time, rat_last_move_time);
+					} else {
+						clear_snapshot();
+					}
+				}
+				
+				// if T pressed initiate Tron Mini Game Mode
+			} else if (event.value == 't' || event.value =='T') {
+				if (!is_replaying()) {
+					apply_game_event(REPLAY_TRON);
+					record_event(get_game_time(), REPLAY_TRON);
+				}
+				
+				// if M pressed switch between the terminal view and
+				// binary telemetry. The view is redrawn a piece per pass
+				// by step_terminal_view().
+			} else if (event.value == 'm' || event.value == 'M') {
+				set_telemetry(!is_telemetry_on());
+				if (is_terminal_view_shown()) {
+					init_terminal_view();
+				}
+				
+				// if X pressed turn channel framing on or off, once
+				// what's already queued has gone
+			} else if (event.value == 'x' || event.value == 'X') {
+				set_channels_framed(!are_channels_framed());
+				
+				// if H pressed then display high scores, a line per pass
+			} else if (event.value == 'h' || event.value == 'H') {
+				next_high_score = 0;
 			}
-			// make sure to ignore other inputs until we move via joystick
-			ignore = 1;
 		}
 		
-		// no joystick or button input so check serial input
-		if(button == -1) {
-			if(serial_input_available()) {
-				serial_input = fgetc(stdin);
-				if(characters_into_escape_sequence == 0 && serial_input == ESCAPE_CHAR) {
-					characters_into_escape_sequence++;
-					serial_input = -1; 
-				} else if(characters_into_escape_sequence == 1 && serial_input == '[') {
-					characters_into_escape_sequence++;
-					serial_input = -1; 
-				} else if(characters_into_escape_sequence == 2) {
-					escape_sequence_char = serial_input;
-					serial_input = -1;  
-					characters_into_escape_sequence = 0;
-				} else {
-					characters_into_escape_sequence = 0;
-				}
+		// advance any LED animations, this never waits
+		step_animations();
+		// and send the next slice of the terminal frame, unless
+		// output is being held for a baud rate or framing change
+		step_baud();
+		// after a framing change the screen is set up again a piece
+		// per pass, as stdout would wait on the terminal channel
+		if (step_channels() && is_terminal_view_shown()) {
+			init_terminal_view();
+		}
+		if (!is_baud_switching() && !is_channel_switching() && is_terminal_view_shown()) {
+			step_terminal_view();
+		}
+		// read a bit more of the leaderboard if the EEPROM is free
+		step_leaderboard();
+		// run the next step of a console command, and show the next
+		// high score line if H asked for them (once the leaderboard
+		// has been read). Both wait for the screen to be set up after
+		// a redraw, so its clear doesn't wipe them.
+		if (!is_baud_switching() && !is_channel_switching() && is_terminal_screen_drawn()) {
+			step_console();
+			if (next_high_score < LEADERBOARD_SHOWN && is_leaderboard_loaded()
+					&& show_high_score(next_high_score)) {
+				next_high_score++;
 			}
 		}
-		// if button or serial input true
-		// then move snake
-		if (!ignore && (button==0 || escape_sequence_char=='C')) {
-			set_snake_dirn(SNAKE_RIGHT);
-		} else  if (!ignore && (button==2 || escape_sequence_char == 'A')) {
-			set_snake_dirn(SNAKE_UP);
-		} else if (!ignore && (button==3 || escape_sequence_char=='D')) {
-			set_snake_dirn(SNAKE_LEFT);
-		} else if (!ignore && (button==1 || escape_sequence_char == 'B')) {
-			set_snake_dirn(SNAKE_DOWN);
-			
-			// if P pressed Pause
-		} else if (serial_input == 'p' || serial_input == 'P') {
-			if (!pause) {
-				pause = 1;
-				pause_time = get_clock_ticks();
-			} else {
-				pause = 0;
-				last_move_time += get_clock_ticks() - pause_time;
-				rat_last_move_time +=  get_clock_ticks() - pause_time;
-				set_super_food_timer(get_super_food_timer() + get_clock_ticks() - pause_time);
+		
+		// Check for timer related events here. Game time catches up
+		// with the clock (or runs ahead of it for a fast replay) a
+		// millisecond at a time, so each event happens at the same game
+		// time however often we get round this loop.
+		game_time = get_game_time();
+		target_time = game_time;
+		now = get_clock_ticks();
+		if (!pause) {
+			target_time += (now - last_clock) * speed;
+		}
+		last_clock = now;
+		// the move time (600ms at speed 1.0 unless changed from the
+		// console), worked out again whenever the speed may change
+		move_time = get_game_timing(TIMING_MOVE) / get_game_speed();
+		while (game_time < target_time) {
+			// a replay makes the player's moves after the same game
+			// time they were made
+			if (is_replaying()) {
+				while ((replay_event = next_replay_event(game_time)) >= 0) {
+					apply_game_event(replay_event);
+					// as the live game did when the console changed it
+					if (replay_event == REPLAY_SETTING) {
+						move_time = get_game_timing(TIMING_MOVE) / get_game_speed();
+					}
+				}
+				// the game being replayed was given up here
+				if (game_time >= get_replay_end_time()) {
+					over = 1;
+					break;
+				}
 			}
+			set_game_time(++game_time);
 			
-			// if T pressed initiate Tron Mini Game Mode
-		} else if (serial_input == 't' || serial_input =='T') {
-			if (!is_tron_mode()) {
-				init_tron();
-				update_display_at_position(get_tron_head_position(), COLOUR_ARC);
-				update_display_at_position(get_tron_tail_position(), COLOUR_RED);
-				set_tron_mode(1);
-			} else {
-				clear_tron();
-				set_tron_mode(0);
+			// check rat time, then step rat
+			if (game_time >= rat_last_move_time + get_game_timing(TIMING_RAT)) {
+				PosnType current_rat_pos = get_position_of_rat();
+				PosnType test_position = step_rat();
+				rat_last_move_time = game_time;
+				if (is_position_valid(test_position)) {
+					update_display_at_position(current_rat_pos, COLOUR_BLACK);
+					update_display_at_position(test_position, COLOUR_ARC);
+					set_rat_pos(test_position);
+				}
 			}
 			
-			// if H pressed then display high scores
-		} else if (serial_input == 'h' || serial_input == 'H') {
-			uint8_t i;
-			for (i = 0; i < 5; i++) {
-				printf_P(PSTR("%d %s - %d\n"), i+1, player_names[i], player_scores[i]);
-			}
-			_delay_ms(1000);
-		}
-		
-		// Check for timer related events here
-		
-		// check rat time, then step rat
-		if (!pause && get_clock_ticks() >= rat_last_move_time + 1000) {
-			PosnType current_rat_pos = get_position_of_rat();
-			PosnType test_position = step_rat();
-			rat_last_move_time = get_clock_ticks();
-			if (is_position_valid(test_position)) {
-				update_display_at_position(current_rat_pos, COLOUR_BLACK);
-				update_display_at_position(test_position, COLOUR_ARC);
-				set_rat_pos(test_position);
+			// check last move time then step snake
+			if (game_time >= last_move_time + move_time) {
+				if(!attempt_to_move_snake_forward()) {
+					// Move attempt failed - game over
+					over = 1;
+					break;
+				}
+				// if Tron mode then also step Tron
+				if (is_tron_mode()) {
+					if (!step_tron()) {
+						clear_tron();
+					}
+				}
+				// move succesfull add score
+				last_move_time = game_time;
+				add_to_score(1);
+				send_telemetry_tick();
+				move_time = get_game_timing(TIMING_MOVE) / get_game_speed();
 			}
-		}
-		
-		// check last move time then step snake
-		if(!pause && get_clock_ticks() >= last_move_time + (600 / get_game_speed())) {
-			// 600ms (0.6 second) has passed since the last time we moved the snake,
-			// so move it now
-			if(!attempt_to_move_snake_forward()) {
-				// Move attempt failed - game over
-				break;
+			
+			// if time is right remove superfood
+			if (is_there_super_food()
+					&& game_time >= get_super_food_timer() + get_game_timing(TIMING_SUPER_FOOD_LIFE)) {
+				update_display_at_position(get_position_of_super_food(), COLOUR_BLACK);
+				reverse_super_food();
 			}
-			// if Tron mode then also step Tron
-			if (is_tron_mode()) {
-				if (!step_tron()) {
-					clear_tron();
+			// if time is right add new superFood
+			if (!is_there_super_food()
+					&& game_time >= get_super_food_timer() + get_game_timing(TIMING_SUPER_FOOD_CYCLE)) {
+				PosnType super_food_pos = add_super_food_item();
+				if (is_position_valid(super_food_pos)) {
+					update_display_at_position(super_food_pos, COLOUR_ORANGE);
+					start_animation(ANIM_SUPER_FOOD_SPAWN, super_food_pos);
+					set_super_food_timer(game_time);
 				}
 			}
-			// move succesfull add score, if move made with joystic change ignore
-			last_move_time = get_clock_ticks();
-			add_to_score(1);
-			if(ignore) {
-				ignore = 0;
-			}
 		}
-		
-		// if time is right remove superfood
-		if (!pause && is_there_super_food() && get_clock_ticks() >= get_super_food_timer() + 5000) {
-			update_display_at_position(get_position_of_super_food(), COLOUR_BLACK);
-			reverse_super_food();
+		if (over || get_replay_request()) {
+			break;
 		}
-		// if time is right add new superFood
-		if (!pause && !is_there_super_food() && get_clock_ticks() >= get_super_food_timer() + 15000) {
-			PosnType super_food_pos = add_super_food_item();
-			if (is_position_valid(super_food_pos)) {
-				update_display_at_position(super_food_pos, COLOUR_ORANGE);
-				set_super_food_timer(get_clock_ticks());
-			}
+		
+		// blink the super food during its last second
+		if (!pause && is_there_super_food() && game_time + SUPER_FOOD_BLINK_TIME
+				>= get_super_food_timer() + get_game_timing(TIMING_SUPER_FOOD_LIFE)
+				&& !is_animation_at(get_position_of_super_food())) {
+			start_animation(ANIM_SUPER_FOOD_EXPIRE, get_position_of_super_food());
 		}
 		// if time is right display length on io board	
 		if (get_clock_ticks() >= last_len_time + 10) {
-			DDRA = 0xFF;
+			// only PA7 is driven, PA0 and PA1 are the joystick ADC inputs
+			DDRA |= 0x80;
 			snake_length = get_snake_length();
 			if (snake_length < 10) {
 				PORTC = seven_seg[snake_length % 10];
@@ -418,39 +521,40 @@ void play_game(void) {
 					control = 1;
 				}
 			}
-			DDRA = 0x00;
+			DDRA &= 0x7f;
 			last_len_time = get_clock_ticks();
 		}
 		
-		// if time is right refresh terminal display
-		if (get_clock_ticks() >= last_print_time + 180) {
-			set_display_attribute(TERM_RESET);
-			clear_terminal();
-			hide_cursor();
-			move_cursor(3,3);
-			// print score
-			printf_P(PSTR("Score: %5ld"), get_score());
-			move_cursor(3,6);
-			printf_P(PSTR("\n"));
-			// print the terminal view Grid
-			print_grid();
-			printf_P(PSTR("\n"));
-			// if Tron mode active print EE message
-			if (is_tron_mode()) {
-				printf_P(PSTR("TRON MODE\n"));
-				printf_P(PSTR("-----------\n"));
-				printf_P(PSTR("CLU: I WILL SHOW YOU NO MERCY, USER!\n"));
-				printf_P(PSTR("TRON: DON'T WORRY USER, I FIGHT FOR THE USERS!\n"));
-			}
-			// if game is on pause print pause
-			if (pause) {
-				printf_P(PSTR("GAME PAUSE"));
+		// if time is right refresh terminal display, only what
+		// changed since the last refresh is sent, a slice per pass
+		if (get_clock_ticks() >= last_print_time + get_game_timing(TIMING_REFRESH)) {
+			if (is_terminal_view_shown()) {
+				start_terminal_frame(pause);
 			}
 			// regresh timer
 			last_print_time = get_clock_ticks();
 		}
 	}
-	// If we get here the game is over. 
+	// If we get here the game is over, or given up for a replay. A
+	// replay should end with the board just as the game did.
+	if (is_replaying()) {
+		if (!get_replay_request()) {
+			replay_in_sync = check_replay(get_state_hash());
+		}
+	} else {
+		end_recording(get_game_time(), get_state_hash());
+		end_game_record();
+		// a game given up while paused isn't carried on after a reset
+		if (pause) {
+			clear_snapshot();
+		}
+	}
+	send_telemetry_game_over();
+	log_P(PSTR("game over score %ld length %d"), get_score(), get_snake_length());
+	// serial input goes back to stdin for the name entry
+	capture_serial_input(0);
+	// blink the snake head where it crashed
+	start_animation(ANIM_DEATH, get_snake_head_position());
 	// reset game speed and remove if there is superfood
 	reset_game_speed();
 	if (is_there_super_food()) {
@@ -460,110 +564,6 @@ void play_game(void) {
 	
 }
 
-//prints grid to the terminal
-void print_grid(void) {
-	uint8_t x, y;
-	for (y = BOARD_HEIGHT + 1; y > 0 ; y--) {
-		for (x = 0; x < BOARD_WIDTH + 2; x++) {
-			if (x != 0 && y != 0 && x != BOARD_WIDTH + 1 && y != BOARD_HEIGHT + 1) {
-				PosnType test_position = position(x - 1, y - 1);
-				if (is_snake_at(test_position)) {
-					if (test_position == get_snake_head_position()) {
-						//uncomment to make it colorful but decreases performance
-						//set_display_attribute(FG_BLUE);
-						printf_P(PSTR("H"));
-					} else if (test_position == get_snake_tail_position()) {
-						//set_display_attribute(FG_BLUE);
-						printf_P(PSTR("T"));
-					} else {
-						//set_display_attribute(FG_MAGENTA);
-						printf_P(PSTR("#"));
-					}
-				} else if (is_rat_at(test_position)) {
-					//set_display_attribute(FG_GREEN);
-					printf_P(PSTR("r"));
-				} else if (is_food_at(test_position)) {
-					//set_display_attribute(FG_WHITE);
-					printf_P(PSTR("f"));
-				} else if (is_super_food_at(test_position)) {
-					//set_display_attribute(FG_RED);
-					printf_P(PSTR("s"));
-				} else {
-					if (is_tron_mode()) {
-						if (is_tron_at(test_position)) {
-							if(test_position == get_tron_tail_position()) {
-								printf_P(PSTR("T"));
-								} else if (test_position == get_tron_head_position()) {
-								printf_P(PSTR("H"));
-								} else {
-								printf_P(PSTR("@"));
-							}
-						} else {
-							printf_P(PSTR(" "));
-						}
-					} else {
-						printf_P(PSTR(" "));
-					}
-					//set_display_attribute(FG_WHITE);
-				}
-			} else {
-				printf_P(PSTR("#"));
-				if (x == BOARD_WIDTH + 1) {
-					printf_P(PSTR("\n"));
-				}
-			}	
-		}
-	}
-	for (x = 0; x < BOARD_WIDTH + 2; x++) {
-		printf_P(PSTR("#"));
-		if (x == BOARD_WIDTH + 1) {
-			printf_P(PSTR("\n"));
-		}
-	}
-}
-
-// default leader board if there is nosaved leader board
-void prepare_default_leaders(char** names, uint16_t* scores) {
-	names[0] = "AAA";
-	names[1] = "BBB";
-	names[2] = "CCC";
-	names[3] = "DDD";
-	names[4] = "EEE";
-	scores[0] = 500;
-	scores[1] = 400;
-	scores[2] = 300;
-	scores[3] = 200;
-	scores[4] = 50;
-}
-
-// check player score vs scores in current leader board
-// if player score enough to join the list then
-// return index value of the position in scores array
-int8_t check_score(uint16_t* scores, uint16_t player_score) {
-	uint8_t i;
-	for (i = 0; i < 5; i++) {
-		if (player_score > scores[i]) {
-			return i;
-		}
-	}
-	return -1;
-}
-
-// adds players score to scores list from given index position, and shifts the array
-void add_score_to_list(char** names, uint16_t* scores, char name[], uint16_t score, uint8_t index) {
-	uint8_t i;
-	for (i = index; i < 5; i++) {
-		scores[i + 1] = scores[i];
-		names[i + 1] = names[i];
-	}
-	/*for (i = 4; i > index; i--) {
-		scores[i] = scores[i - 1];
-		names[i] = names[i - 1];
-	}*/
-	scores[index] = score;
-	names[index] = name;
-}
-
 // removes extra white space
 void strip_name(char* name) {
 	uint8_t i;
@@ -574,14 +574,24 @@ void strip_name(char* name) {
 	}
 }
 
-// stored bytes on rom
-uint8_t gather_byte_size(char** names) {
-	uint8_t result = 0;
-	uint8_t i;
-	for (i = 0 ; i < 5; i++) {
-		result += (uint8_t) strlen(names[i]);
+// reads a line of at most size - 1 characters into name, including
+// the \n that ends it, as fgets() would - but a character at a time,
+// keeping LED animations running while waiting for each one
+static void read_player_name(char* name, uint8_t size) {
+	uint8_t length = 0;
+	int c;
+	while (length < size - 1) {
+		if (!serial_input_available()) {
+			step_animations();
+			continue;
+		}
+		c = fgetc(stdin);
+		name[length++] = c;
+		if (c == '\n') {
+			break;
+		}
 	}
-	return result;
+	name[length] = 0;
 }
 
 // handle end game
@@ -590,105 +600,69 @@ void handle_game_over() {
 	normal_display_mode();
 	reverse_video();
 	
-	// check if first time player
-	if (!old_player) {
-		// allocate memory for names and scores
-		char** names = malloc(sizeof(char*) * 5);
-		uint16_t* scores = malloc(sizeof(uint16_t) * 5);
-		
-		// prepare default leader board
-		prepare_default_leaders(names, scores);
-		
-		// check player score
-		uint16_t player_score = (uint16_t) get_score();
-		int8_t index = check_score(scores, player_score);
-		if (index!= -1) {
-			char name[20];
-			move_cursor(10,14);
-			// Print a message to the terminal.
-			show_cursor();
-			printf_P(PSTR("GAME OVER\n"));
-			printf_P(PSTR("You Scored %d\n"), get_score());
-			printf_P(PSTR("Please enter your name: \n"));
-			fgets(name, 20, stdin);
-			printf_P(PSTR("Thank you for playing %s\n"), name);
-			strip_name(name);
-			add_score_to_list(names, scores, name, player_score, index);
-			printf_P(PSTR("Highscores: \n"));
-			uint8_t i;
-			uint8_t j;
-			uint8_t* pos = (uint8_t*)90;
-			for (i = 0; i < 5; i++) {
-				printf_P(PSTR("%d. %s : %d \n"), i+1, names[i], scores[i]);
-			}
-			eeprom_write_byte (pos, control_character);
-			uint8_t totalByte = gather_byte_size(names);
-
-			eeprom_write_byte (pos - 1, totalByte);
-			for (i = 0; i < 5; i++) {
-				for (j = 0; j < strlen(names[i]); j++) {
-					eeprom_write_byte ((uint8_t*) ++pos, (uint8_t)names[i][j]);
-				}
-				eeprom_write_byte (++pos, (uint8_t)':');
-			}
-			eeprom_write_word((uint16_t*)300, scores[0]);
-			eeprom_write_word((uint16_t*)302, scores[1]);
-			eeprom_write_word((uint16_t*)304, scores[2]);
-			eeprom_write_word((uint16_t*)306, scores[3]);
-			eeprom_write_word((uint16_t*)308, scores[4]);
-			
-		} 
+	uint16_t player_score = get_score() > 0xFFFF ? 0xFFFF : get_score();
+	// a replay doesn't go on the leader board again
+	int8_t rank = is_replaying() ? -1 : get_leaderboard_rank(player_score);
+	uint8_t i;
+	int key;
+	move_cursor(10,14);
+	// Print a message to the terminal.
+	show_cursor();
+	if (is_replaying()) {
+		printf_P(PSTR("REPLAY OVER\n"));
+		if (!replay_in_sync) {
+			printf_P(PSTR("Replay went out of step with the game\n"));
+		}
+		stop_replay();
 	} else {
-		uint16_t player_score = get_score();
-		int8_t index = check_score(player_scores, player_score);
-		char name[20];
-		move_cursor(10,14);
-		// Print a message to the terminal.
-		show_cursor();
-		// print game over
 		printf_P(PSTR("GAME OVER\n"));
-		printf_P(PSTR("You Scored %d\n"), get_score());
+	}
+	printf_P(PSTR("You Scored %ld\n"), get_score());
+	
+	// get the player's name if they made the leader board
+	if (rank != -1) {
+		char name[20];
 		printf_P(PSTR("Please enter your name: \n"));
-		
-		// getplayer name
-		fgets(name, 20, stdin);
+		read_player_name(name, sizeof(name));
 		printf_P(PSTR("Thank you for playing %s\n"), name);
 		strip_name(name);
-		// add player to list
-		add_score_to_list(player_names, player_scores, name, player_score, index);
-		printf_P(PSTR("Highscores: \n"));
-		uint8_t i;
-		uint8_t j;
-		uint8_t* pos = (uint8_t*)90;
-		for (i = 0; i < 5; i++) {
-			printf_P(PSTR("%d. %s : %d \n"), i+1, player_names[i], player_scores[i]);
-		}
-		eeprom_write_byte (pos, control_character);
-		uint8_t totalByte = gather_byte_size(player_names);
-
-		eeprom_write_byte (pos - 1, totalByte);
-		for (i = 0; i < 5; i++) {
-			for (j = 0; j < strlen(player_names[i]); j++) {
-				eeprom_write_byte ((uint8_t*) ++pos, (uint8_t)player_names[i][j]);
-			}
-			eeprom_write_byte (++pos, (uint8_t)':');
-		}
-		eeprom_write_word((uint16_t*)300, player_scores[0]);
-		eeprom_write_word((uint16_t*)302, player_scores[1]);
-		eeprom_write_word((uint16_t*)304, player_scores[2]);
-		eeprom_write_word((uint16_t*)306, player_scores[3]);
-		eeprom_write_word((uint16_t*)308, player_scores[4]);
-	
+		add_to_leaderboard(name, player_score);
+		save_leaderboard();
+	}
+	printf_P(PSTR("Highscores: \n"));
+	for (i = 0; i < LEADERBOARD_SHOWN && i < get_leaderboard_count(); i++) {
+		printf_P(PSTR("%d. %s : %u \n"), i+1, get_leader_name(i), get_leader_score(i));
+	}
+	// the table goes further down than is shown
+	if (rank >= LEADERBOARD_SHOWN) {
+		printf_P(PSTR("You are number %d of %d\n"), rank + 1, get_leaderboard_count());
 	}
 
 	move_cursor(10,25);
-	printf_P(PSTR("Press a button to start again"));
+	if (can_replay()) {
+		printf_P(PSTR("Press a button to start again, or 1-%d to replay at that speed"),
+				MAX_REPLAY_SPEED);
+	} else {
+		printf_P(PSTR("Press a button to start again"));
+	}
 	if (is_tron_mode()) {
 		clear_tron();
 		set_tron_mode(0);
 	}
-	while(is_there_joystic_input() || button_pushed() == -1) {
-		get_volt(); // wait until a button has been pushed
+	InputEvent event;
+	while (1) {
+		// wait until a button has been pushed, or a replay speed typed
+		step_animations();
+		if (get_input_event(&event) && event.source == INPUT_BUTTON) {
+			break;
+		}
+		if (can_replay() && serial_input_available()) {
+			key = fgetc(stdin);
+			if (key >= '1' && key <= '0' + MAX_REPLAY_SPEED) {
+				start_replay(key - '0');
+				break;
+			}
+		}
 	}
 	
 }
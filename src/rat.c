@@ -4,7 +4,6 @@
 ** Written by Arda Akgur
 */
 
-#include <stdlib.h>
 #include "position.h"
 #include "food.h"
 #include "snake.h"
@@ -13,6 +12,8 @@
 #include "rat.h"
 #include "timer0.h"
 #include "tron.h"
+#include "prng.h"
+#include "state_hash.h"
 
 // current position of Rat
 static PosnType ratPosition;
@@ -21,6 +22,8 @@ static PosnType ratPosition;
 
 // sets new position for rat
 void set_rat_pos(PosnType posn) {
+	toggle_state_hash(HASH_RAT, ratPosition);
+	toggle_state_hash(HASH_RAT, posn);
 	ratPosition = posn;
 }
 
@@ -43,19 +46,16 @@ PosnType get_position_of_rat(void) {
 */
 PosnType add_rat_item(void) {
 
-	/* Generate "random" positions until we get one which
+	/* Generate random positions until we get one which
 	** is not occupied by a snake or food.
 	*/
 	int8_t x, y, attempts;
 	PosnType test_position;
-	x = 0;
-	y = 0;
 	attempts = 0;
 	do {
-		// Generate a new position - this is based on a sequence rather
-		// then being random
-        x = (x+3+attempts)%BOARD_WIDTH;
-        y = (y+5)%BOARD_HEIGHT;
+		// Generate a new random position
+        x = random_below(BOARD_WIDTH);
+        y = random_below(BOARD_HEIGHT);
 		test_position = position(x,y);
         attempts++;
     } while(attempts < 100 && 
@@ -71,7 +71,7 @@ PosnType add_rat_item(void) {
 	// If we get here, we've found an unoccupied position (test_position)
 	// Add it to our list, display it, and return its ID.
 	
-	ratPosition = test_position;
+	set_rat_pos(test_position);
 	return test_position;
 }
 
@@ -82,7 +82,7 @@ PosnType step_rat(void) {
     PosnType test_position = ratPosition;
     int8_t attempts = 0;
     do {
-        switch (random() % 4) {
+        switch (random_below(4)) {
             case 0:
                 test_position = position(x, y + 1);
                 break;
@@ -0,0 +1,209 @@
+/*
+** replay.c
+**
+** Written by Arda Akgur
+**
+** Each event is stored as the game time since the event before it
+** (the delta) and the event. The first byte holds the event in its
+** top 3 bits, a flag in bit 4 saying more bytes of the delta follow,
+** and the low 4 bits of the delta. The rest of the delta follows 7
+** bits a byte, lowest first, with the top bit set if there is more.
+** Events less than 16ms apart take one byte and events up to two
+** seconds apart take two. A setting change is followed by three more
+** bytes, the setting then its value, low byte first.
+*/
+
+#include "replay.h"
+#include "game.h"
+
+#define EVENT_SHIFT 5
+#define MORE_BIT 0x10
+#define DELTA_MASK 0x0F
+
+static uint8_t buffer[REPLAY_BUFFER_SIZE];
+static uint8_t length;
+static uint8_t complete;
+static uint16_t seed;
+static uint32_t end_time;
+static uint32_t end_hash;
+
+// speed and timings the recorded game started with
+static float start_speed;
+static uint16_t start_timings[NUM_TIMINGS];
+
+// game time of the last event recorded or replayed
+static uint32_t last_time;
+
+// replay state - where the next event is read from in the buffer, and
+// the next event and its game time once they've been read
+static uint8_t replaying;
+static uint8_t speed;
+static uint8_t requested_speed;
+static uint8_t read_position;
+static int8_t next_event;
+static uint32_t next_time;
+
+// the next event's setting and value if it's a REPLAY_SETTING, and
+// those of the event last returned
+static uint8_t next_setting;
+static uint16_t next_value;
+static uint8_t setting;
+static uint16_t setting_value;
+
+void start_recording(uint16_t game_seed) {
+	uint8_t i;
+	seed = game_seed;
+	length = 0;
+	complete = 1;
+	last_time = 0;
+	start_speed = get_game_speed();
+	for (i = 0; i < NUM_TIMINGS; i++) {
+		start_timings[i] = get_game_timing(i);
+	}
+}
+
+void record_event(uint32_t time, uint8_t event) {
+	uint32_t delta = time - last_time;
+	uint8_t start = length;
+	if (!complete) {
+		return;
+	}
+	last_time = time;
+	if (length == REPLAY_BUFFER_SIZE) {
+		complete = 0;
+		return;
+	}
+	buffer[length++] = (event << EVENT_SHIFT) | (delta & DELTA_MASK)
+			| (delta > DELTA_MASK ? MORE_BIT : 0);
+	delta >>= 4;
+	while (delta) {
+		if (length == REPLAY_BUFFER_SIZE) {
+			// drop the partly written event
+			length = start;
+			complete = 0;
+			return;
+		}
+		buffer[length++] = (delta & 0x7F) | (delta > 0x7F ? 0x80 : 0);
+		delta >>= 7;
+	}
+}
+
+void record_setting(uint32_t time, uint8_t new_setting, uint16_t value) {
+	uint8_t start = length;
+	record_event(time, REPLAY_SETTING);
+	if (!complete) {
+		return;
+	}
+	if (length + 3 > REPLAY_BUFFER_SIZE) {
+		length = start;
+		complete = 0;
+		return;
+	}
+	buffer[length++] = new_setting;
+	buffer[length++] = value & 0xFF;
+	buffer[length++] = value >> 8;
+}
+
+void end_recording(uint32_t time, uint32_t hash) {
+	end_time = time;
+	end_hash = hash;
+}
+
+void cancel_recording(void) {
+	complete = 0;
+}
+
+uint8_t can_replay(void) {
+	return complete;
+}
+
+// reads the next event and its time, or sets next_event to -1 at the
+// end of the recording
+static void read_event(void) {
+	uint8_t byte;
+	uint32_t delta;
+	uint8_t shift = 4;
+	if (read_position >= length) {
+		next_event = -1;
+		return;
+	}
+	byte = buffer[read_position++];
+	next_event = byte >> EVENT_SHIFT;
+	delta = byte & DELTA_MASK;
+	if (byte & MORE_BIT) {
+		do {
+			byte = buffer[read_position++];
+			delta |= (uint32_t)(byte & 0x7F) << shift;
+			shift += 7;
+		} while (byte & 0x80);
+	}
+	if (next_event == REPLAY_SETTING) {
+		next_setting = buffer[read_position];
+		next_value = buffer[read_position + 1] | (buffer[read_position + 2] << 8);
+		read_position += 3;
+	}
+	next_time = last_time + delta;
+	last_time = next_time;
+}
+
+void request_replay(uint8_t replay_speed) {
+	requested_speed = replay_speed;
+}
+
+uint8_t get_replay_request(void) {
+	return requested_speed;
+}
+
+void start_replay(uint8_t replay_speed) {
+	uint8_t i;
+	set_game_speed(start_speed);
+	for (i = 0; i < NUM_TIMINGS; i++) {
+		set_game_timing(i, start_timings[i]);
+	}
+	replaying = 1;
+	speed = replay_speed;
+	requested_speed = 0;
+	read_position = 0;
+	last_time = 0;
+	read_event();
+}
+
+uint8_t check_replay(uint32_t hash) {
+	return hash == end_hash;
+}
+
+void stop_replay(void) {
+	replaying = 0;
+}
+
+uint8_t is_replaying(void) {
+	return replaying;
+}
+
+uint8_t get_replay_speed(void) {
+	return speed;
+}
+
+uint16_t get_replay_seed(void) {
+	return seed;
+}
+
+uint32_t get_replay_end_time(void) {
+	return end_time;
+}
+
+int8_t next_replay_event(uint32_t time) {
+	int8_t event = next_event;
+	if (event < 0 || next_time > time) {
+		return -1;
+	}
+	setting = next_setting;
+	setting_value = next_value;
+	read_event();
+	return event;
+}
+
+uint8_t get_replay_setting(uint16_t* value) {
+	*value = setting_value;
+	return setting;
+}
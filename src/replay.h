@@ -0,0 +1,139 @@
+/*
+** replay.h
+**
+** Written by Arda Akgur
+**
+** Recording and replaying games. The game logic runs on game time
+** (see get_game_time() in game.h), which only moves on while a game is
+** being played, and the only other things that change a game are the
+** player's input and the speed and timings set from the console. So a
+** game is recorded as the random seed, speed and timings it started
+** with and each input or setting that changed it, with the game time
+** it happened at, and replaying those at the same game times plays the
+** same game again - as fast as we like.
+**
+** The last game started is kept in RAM and can be replayed from the
+** game over screen or the console. The buffer holds about 80 turns -
+** a game with more can't be replayed.
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <inttypes.h>
+
+// Bytes of RAM for the recording. Most events take 2 bytes.
+#define REPLAY_BUFFER_SIZE 160
+
+// Fastest replay, times real time
+#define MAX_REPLAY_SPEED 9
+
+// Events that change a game. Directions are SnakeDirnType values.
+// Pausing doesn't need recording as game time stops with it.
+#define REPLAY_TRON 4
+#define REPLAY_SETTING 5	// see record_setting()
+
+/* start_recording(seed)
+**
+** Throw away the last recording and start a new one for a game
+** started with the given random state (see prng.h). The game speed
+** and timings at the time are kept too.
+*/
+void start_recording(uint16_t seed);
+
+/* record_event(time, event)
+**
+** Add an event that happened at the given game time (which must not be
+** before the last event). If the buffer is full the recording is
+** marked incomplete and can't be replayed.
+*/
+void record_event(uint32_t time, uint8_t event);
+
+/* record_setting(time, setting, value)
+**
+** Add a change to the speed or one of the timings (setting and value
+** as for set_game_setting() in game.h) as a REPLAY_SETTING event.
+*/
+void record_setting(uint32_t time, uint8_t setting, uint16_t value);
+
+/* end_recording(time, hash)
+**
+** Finish the recording with the game time and state hash (see
+** state_hash.h) the game ended with.
+*/
+void end_recording(uint32_t time, uint32_t hash);
+
+/* cancel_recording()
+**
+** Mark the recording incomplete, for a game that didn't start from
+** its seed (e.g. one carried on from a snapshot).
+*/
+void cancel_recording(void);
+
+/* can_replay()
+**
+** Returns 1 if there is a complete recording to replay.
+*/
+uint8_t can_replay(void);
+
+/* request_replay(speed) and get_replay_request()
+**
+** Ask for a replay at the given speed to start in place of the game
+** being played (e.g. from the console), and the speed asked for, 0 if
+** none has been. The game loop should end the game when one is asked
+** for and start_replay() it.
+*/
+void request_replay(uint8_t speed);
+uint8_t get_replay_request(void);
+
+/* start_replay(speed)
+**
+** Start replaying the recording at the given speed (1 to
+** MAX_REPLAY_SPEED times real time). Any request is cleared, and the
+** speed and timings go back to those the recorded game started with.
+** The game should then be started with get_replay_seed() as its
+** random state.
+*/
+void start_replay(uint8_t speed);
+
+/* check_replay(hash)
+**
+** Returns 1 if the replay ended with the given state hash, the same
+** as the game it replayed, 0 if it went out of step.
+*/
+uint8_t check_replay(uint32_t hash);
+
+/* stop_replay()
+**
+** Stop replaying - the recording is kept.
+*/
+void stop_replay(void);
+
+/* is_replaying(), get_replay_speed(), get_replay_seed() and
+** get_replay_end_time()
+**
+** Whether a replay is going on, how fast, and the seed and game time
+** at the end of the game being replayed. A replay should stop at the
+** end time if it hasn't already ended.
+*/
+uint8_t is_replaying(void);
+uint8_t get_replay_speed(void);
+uint16_t get_replay_seed(void);
+uint32_t get_replay_end_time(void);
+
+/* next_replay_event(time)
+**
+** Returns the next recorded event if it happened at or before the
+** given game time (and moves on to the one after), -1 otherwise.
+*/
+int8_t next_replay_event(uint32_t time);
+
+/* get_replay_setting(value)
+**
+** For a REPLAY_SETTING event just returned by next_replay_event(),
+** returns the setting and puts its new value in *value.
+*/
+uint8_t get_replay_setting(uint16_t* value);
+
+#endif
@@ -12,6 +12,12 @@
  * put method will either
  * (1) if interrupts are enabled, block until there is room in it, or
  * (2) if interrupts are disabled, will discard the character.
+ * serial_write() and serial_write_P() never block - they take only
+ * what fits in the buffer.
+ * Both buffers are single producer, single consumer rings: only the
+ * producer moves the head and only the consumer moves the tail, so
+ * neither side needs to disable interrupts. (The exception is echo,
+ * where the receive interrupt also writes to the output buffer.)
  * Input is blocking - requesting input from stdin will block
  * until a character is available. If interrupts are disabled when 
  * input is sought, then this will block forever.
@@ -25,34 +31,49 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#include "serialio.h"
 
 /* System clock rate in Hz. (L at the end indicates this is a long constant) */
 #define SYSCLK 8000000L
 
 /* Global variables */
-/* Circular buffer to hold outgoing characters. The insert_pos variable
- * keeps track of the position (0 to OUTPUT_BUFFER_SIZE-1) that the next
- * outgoing character should be written to. bytes_in_buffer keeps
- * count of the number of characters currently stored in the buffer 
- * (ranging from 0 to OUTPUT_BUFFER_SIZE). This number of bytes immediately
- * prior to the current insert_pos are the bytes waiting to be output.
- * If the insert_pos reaches the end of the buffer it will wrap around
- * to the beginning (assuming those bytes have been output).
- * NOTE - OUTPUT_BUFFER_SIZE can not be larger than 255 without changing
+/* Circular buffer to hold outgoing characters. out_head is the position
+ * the next outgoing character is written to (only changed by the
+ * put functions) and out_tail is the position of the next character
+ * to send (only changed by the UDRE interrupt handler). Positions wrap
+ * around by masking, so the buffer size must be a power of two, and
+ * the buffer is empty when they are equal. One position is always left
+ * unused so that a full buffer can be told apart from an empty one.
+ * NOTE - OUTPUT_BUFFER_SIZE can not be larger than 256 without changing
  * the type of the variables below (currently defined as 8 bit unsigned ints).
  */
-#define OUTPUT_BUFFER_SIZE 255
+#define OUTPUT_BUFFER_SIZE 256
+#define OUTPUT_BUFFER_MASK (OUTPUT_BUFFER_SIZE - 1)
 volatile char out_buffer[OUTPUT_BUFFER_SIZE];
-volatile uint8_t out_insert_pos;
-volatile uint8_t bytes_in_out_buffer;
+volatile uint8_t out_head;
+volatile uint8_t out_tail;
+
+/* Count of characters put into the output buffer */
+static volatile uint32_t out_count;
+
+/* Set once a character has been written to the UART - until then the
+ * transmit complete flag (TXC0) isn't meaningful.
+ */
+static volatile uint8_t tx_started;
+
+/* Baud rate the UART is set up for */
+static long current_baud;
 
 /* Circular buffer to hold incoming characters. Works on same principle
- * as output buffer
+ * as output buffer, with the receive interrupt handler as the producer
  */
 #define INPUT_BUFFER_SIZE 16
+#define INPUT_BUFFER_MASK (INPUT_BUFFER_SIZE - 1)
 volatile char input_buffer[INPUT_BUFFER_SIZE];
-volatile uint8_t input_insert_pos;
-volatile uint8_t bytes_in_input_buffer;
+volatile uint8_t input_head;
+volatile uint8_t input_tail;
 volatile uint8_t input_overrun;
 
 /* Variable to keep track of whether incoming characters are to be echoed
@@ -60,9 +81,26 @@ volatile uint8_t input_overrun;
  */
 static int8_t do_echo;
 
+/* Function that receives incoming characters instead of the input
+ * buffer (0 if characters are to be buffered).
+ */
+static void (* volatile input_handler)(char);
+
+/* Function that receives every byte as it arrives, before any echo or
+ * CR handling (0 if there isn't one).
+ */
+static void (* volatile raw_input_handler)(char);
+
+/* Function the UDRE interrupt handler asks for the next byte to send
+ * once the output buffer is empty. Returns -1 if it has nothing.
+ */
+static int16_t (* volatile output_source)(void);
+
 /* Function prototypes 
  */
 void init_serial_stdio(long baudrate, int8_t echo);
+int8_t set_serial_baud(long baudrate);
+void serial_receive_char(char c);
 static int uart_put_char(char, FILE*);
 static int uart_get_char(FILE*);
 
@@ -73,28 +111,31 @@ static FILE myStream = FDEV_SETUP_STREAM(uart_put_char, uart_get_char,
 		_FDEV_SETUP_RW);
 
 void init_serial_stdio(long baudrate, int8_t echo) {
-	uint16_t ubrr;
 	/*
 	 * Initialise our buffers
 	*/
-	out_insert_pos = 0;
-	bytes_in_out_buffer = 0;
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
+	out_head = 0;
+	out_tail = 0;
+	out_count = 0;
+	input_head = 0;
+	input_tail = 0;
 	input_overrun = 0;
+	input_handler = 0;
+	raw_input_handler = 0;
+	output_source = 0;
+	tx_started = 0;
 	
 	/*
 	 * Record whether we're going to echo characters or not
 	*/
 	do_echo = echo;
 	
-	/* Configure the serial port baud rate */
-	/* (This differs from the datasheet formula so that we get 
-	 * rounding to the nearest integer while using integer division
-	 * (which truncates)).
+	/* Configure the serial port baud rate, falling back to 19200 if
+	 * the rate asked for can't be made accurately enough
 	*/
-	ubrr = ((SYSCLK / (8 * baudrate)) + 1)/2 - 1;
-	UBRR0 = ubrr;
+	if(set_serial_baud(baudrate) != 0) {
+		set_serial_baud(19200);
+	}
 	
 	/*
 	 * Enable transmission and receiving via UART. We don't enable
@@ -118,98 +159,219 @@ void init_serial_stdio(long baudrate, int8_t echo) {
 	stdin = &myStream;
 }
 
+int8_t set_serial_baud(long baudrate) {
+	uint8_t u2x;
+	uint32_t divisor;
+	uint32_t ubrr;
+	uint32_t actual;
+	uint32_t error;
+	uint32_t best_error = 0xFFFFFFFF;
+	uint16_t best_ubrr = 0;
+	uint8_t best_u2x = 0;
+	
+	if(baudrate <= 0) {
+		return -1;
+	}
+	
+	/* Work out the divisor for normal speed (UBRR+1 counts of 16
+	 * clocks per bit) and double speed (U2X, 8 clocks per bit). Double
+	 * speed has finer steps but samples each bit fewer times, so it's
+	 * only used if it is closer to the rate asked for.
+	 * (The divisor is rounded to the nearest integer rather than
+	 * truncated as the datasheet formula does.)
+	*/
+	for(u2x = 0; u2x < 2; u2x++) {
+		divisor = u2x ? 8 : 16;
+		ubrr = (SYSCLK + divisor * baudrate / 2) / (divisor * baudrate);
+		if(ubrr == 0 || ubrr > 4096) {
+			continue;
+		}
+		ubrr--;
+		actual = SYSCLK / (divisor * (ubrr + 1));
+		if(actual > (uint32_t)baudrate) {
+			error = (actual - baudrate) * 1000 / baudrate;
+		} else {
+			error = (baudrate - actual) * 1000 / baudrate;
+		}
+		if(error < best_error) {
+			best_error = error;
+			best_ubrr = ubrr;
+			best_u2x = u2x;
+		}
+	}
+	if(best_error > MAX_BAUD_ERROR) {
+		return -1;
+	}
+	
+	UCSR0A = best_u2x ? (1 << U2X0) : 0;
+	UBRR0 = best_ubrr;
+	current_baud = baudrate;
+	return 0;
+}
+
+long get_serial_baud(void) {
+	return current_baud;
+}
+
+uint8_t serial_output_idle(void) {
+	/* The UDRE interrupt stays enabled while the buffer or the output
+	 * source has anything left, and the UART must have finished
+	 * shifting out the last character
+	*/
+	return bit_is_clear(UCSR0B, UDRIE0) && (!tx_started || bit_is_set(UCSR0A, TXC0));
+}
+
+void set_serial_input_handler(void (*handler)(char)) {
+	input_handler = handler;
+}
+
+void set_serial_raw_input_handler(void (*handler)(char)) {
+	raw_input_handler = handler;
+}
+
+void set_serial_output_source(int16_t (*source)(void)) {
+	output_source = source;
+}
+
+void start_serial_output(void) {
+	UCSR0B |= (1 << UDRIE0);
+}
+
+uint32_t get_serial_output_count(void) {
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint32_t count = out_count;
+	if(interrupts_enabled) {
+		sei();
+	}
+	return count;
+}
+
+uint8_t serial_output_space(void) {
+	return (uint8_t)(out_tail - out_head - 1) & OUTPUT_BUFFER_MASK;
+}
+
+/* Put a character in the output buffer, returning 0 if it is full.
+ * The character is stored before the head is moved past it, so the
+ * UDRE interrupt handler never sees a position that isn't written yet.
+ * (Both are volatile, so the compiler keeps them in this order.)
+ */
+static inline uint8_t out_buffer_put(char c) {
+	uint8_t head = out_head;
+	uint8_t next = (head + 1) & OUTPUT_BUFFER_MASK;
+	if(next == out_tail) {
+		return 0;
+	}
+	out_buffer[head] = c;
+	out_head = next;
+	return 1;
+}
+
+/* Make sure the UDRE interrupt is enabled so it sends what's been put
+ * in the buffer. The handler only ever clears this bit and only when
+ * the buffer is empty, so setting it here can't lose anything.
+ */
+static inline void start_output(void) {
+	UCSR0B |= (1 << UDRIE0);
+}
+
+/* Only needed if echo is on, when the receive interrupt handler also
+ * puts characters in the output buffer.
+ */
+static inline uint8_t begin_output(void) {
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	if(do_echo) {
+		cli();
+	}
+	return interrupts_enabled;
+}
+
+static inline void end_output(uint8_t interrupts_enabled) {
+	if(do_echo && interrupts_enabled) {
+		sei();
+	}
+}
+
+uint8_t serial_write(const char* data, uint8_t length) {
+	uint8_t interrupts_enabled = begin_output();
+	uint8_t written = 0;
+	
+	while(written < length && out_buffer_put(data[written])) {
+		written++;
+	}
+	out_count += written;
+	start_output();
+	end_output(interrupts_enabled);
+	return written;
+}
+
+uint8_t serial_write_P(const char* data) {
+	uint8_t interrupts_enabled = begin_output();
+	uint8_t written = 0;
+	char c;
+	
+	while((c = pgm_read_byte(data)) && out_buffer_put(c)) {
+		data++;
+		written++;
+	}
+	out_count += written;
+	start_output();
+	end_output(interrupts_enabled);
+	return written;
+}
+
 int8_t serial_input_available(void) {
-	return (bytes_in_input_buffer != 0);
+	return (input_head != input_tail);
 }
 
 void clear_serial_input_buffer(void) {
-	/* Just adjust our buffer data so it looks empty */
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
+	/* Just move our tail up to the head so it looks empty */
+	input_tail = input_head;
 }
 
 static int uart_put_char(char c, FILE* stream) {
-	uint8_t interrupts_enabled;
-	
-	/* Add the character to the buffer for transmission (if there 
-	 * is space to do so). If not we wait until the buffer has space.
-	 * If the character is \n, we output \r (carriage return)
-	 * also.
+	/* stdio hands us one character at a time - avr-libc streams have
+	 * no way to pass on a whole block - so this just feeds it to
+	 * serial_write(), the same ring insert the block writers use.
+	 * A \n goes out as \r\n (carriage return first), in one write.
 	*/
-	if(c == '\n') {
-		uart_put_char('\r', stream);
-	}
+	char data[2] = {'\r', c};
+	const char* next = (c == '\n') ? data : data + 1;
+	uint8_t length = (c == '\n') ? 2 : 1;
+	uint8_t written;
 	
 	/* If the buffer is full and interrupts are disabled then we
-	 * abort - we don't output the character since the buffer will
-	 * never be emptied if interrupts are disabled. If the buffer is full
-	 * and interrupts are enabled then we loop until the buffer has 
-	 * enough space. The bytes_in_buffer variable will get modified by the
-	 * ISR which extracts bytes from the buffer.
+	 * abort - the buffer will never be emptied if interrupts are
+	 * disabled. If interrupts are enabled then we loop until the
+	 * ISR has made enough room.
 	*/
-	interrupts_enabled = bit_is_set(SREG, SREG_I);
-	while(bytes_in_out_buffer >= OUTPUT_BUFFER_SIZE) {
-		if(!interrupts_enabled) {
+	while(1) {
+		written = serial_write(next, length);
+		next += written;
+		length -= written;
+		if(length == 0) {
+			return 0;
+		}
+		if(bit_is_clear(SREG, SREG_I)) {
 			return 1;
-		}		
-		/* else do nothing */
-	}
-	
-	/* Add the character to the buffer for transmission if there
-	 * is space to do so. We advance the insert_pos to the next
-	 * character position. If this is beyond the end of the buffer
-	 * we wrap around back to the beginning of the buffer 
-	 * NOTE: we disable interrupts before modifying the buffer. This
-	 * prevents the ISR from modifying the buffer at the same time.
-	 * We reenable them if they were enabled when we entered the
-	 * function.
-	*/	
-	cli();
-	out_buffer[out_insert_pos++] = c;
-	bytes_in_out_buffer++;
-	if(out_insert_pos == OUTPUT_BUFFER_SIZE) {
-		/* Wrap around buffer pointer if necessary */
-		out_insert_pos = 0;
-	}
-	/* Reenable interrupts (UDR Empty interrupt may have been
-	 * disabled) - we ensure it is now enabled so that it will
-	 * fire and deal with the next character in the buffer. */
-	UCSR0B |= (1 << UDRIE0);
-	if(interrupts_enabled) {
-		sei();
+		}
 	}
-	return 0;
 }
 
 int uart_get_char(FILE* stream) {
+	char c;
+	
 	/* Wait until we've received a character */
-	while(bytes_in_input_buffer == 0) {
+	while(input_head == input_tail) {
 		/* do nothing */
 	}
 	
 	/*
-	 * Turn interrupts off and remove a character from the input
-	 * buffer. We reenable interrupts if they were on.
-	 * The pending character is the one which is byte_in_input_buffer
-	 * characters before the insert position (taking into account
-	 * that we may need to wrap around).
+	 * Take the character at the tail, then move the tail past it so
+	 * the receive ISR can reuse the position.
 	 */
-	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
-	cli();
-	char c;
-	if(input_insert_pos - bytes_in_input_buffer < 0) {
-		/* Need to wrap around */
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer
-				+ INPUT_BUFFER_SIZE];
-	} else {
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer];
-	}
-	
-	/* Decrement our count of bytes in the input buffer */
-	bytes_in_input_buffer--;
-	if(interrupts_enabled) {
-		sei();
-	}	
+	c = input_buffer[input_tail];
+	input_tail = (input_tail + 1) & INPUT_BUFFER_MASK;
 	return c;
 }
 
@@ -219,28 +381,29 @@ int uart_get_char(FILE* stream) {
  */
 ISR(USART0_UDRE_vect) 
 {
-	/* Check if we have data in our buffer */
-	if(bytes_in_out_buffer > 0) {
-		/* Yes we do - remove the pending byte and output it
-		 * via the UART. The pending byte (character) is the
-		 * one which is "bytes_in_buffer" characters before the 
-		 * insert_pos (taking into account that we may 
-		 * need to wrap around to the end of the buffer).
+	int16_t c = -1;
+	
+	/* Check if we have data in our buffer, or failing that if the
+	 * output source has any
+	 */
+	if(out_tail != out_head) {
+		/* Yes we do - take the character at the tail and move the
+		 * tail on to the next one.
 		 */
-		char c;
-		if(out_insert_pos - bytes_in_out_buffer < 0) {
-			/* Need to wrap around */
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer
-				+ OUTPUT_BUFFER_SIZE];
-		} else {
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer];
-		}
-		/* Decrement our count of the number of bytes in the 
-		 * buffer 
+		uint8_t tail = out_tail;
+		c = (uint8_t)out_buffer[tail];
+		out_tail = (tail + 1) & OUTPUT_BUFFER_MASK;
+	} else if(output_source) {
+		c = output_source();
+	}
+	
+	if(c >= 0) {
+		/* Clear the transmit complete flag (by writing a 1 to it)
+		 * so it shows when this character has gone. Writing 0 to
+		 * the other flags leaves them alone.
 		 */
-		bytes_in_out_buffer--;
-		
-		/* Output the character via the UART */
+		UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << TXC0);
+		tx_started = 1;
 		UDR0 = c;
 	} else {
 		/* No data in the buffer. We disable the UART Data
@@ -255,8 +418,9 @@ ISR(USART0_UDRE_vect)
 
 /*
  * Define the interrupt handler for UART Receive Complete (i.e. 
- * we can read a character. The character is read and placed in
- * the input buffer.
+ * we can read a character. The character is read and passed to the
+ * raw input handler if there is one, otherwise it is received as
+ * usual.
  */
 
 ISR(USART0_RX_vect) 
@@ -264,8 +428,16 @@ ISR(USART0_RX_vect)
 	/* Read the character - we ignore the possibility of overrun. */
 	char c;
 	c = UDR0;
-		
-	if(do_echo && bytes_in_out_buffer < OUTPUT_BUFFER_SIZE) {
+	
+	if(raw_input_handler) {
+		raw_input_handler(c);
+	} else {
+		serial_receive_char(c);
+	}
+}
+
+void serial_receive_char(char c) {
+	if(do_echo) {
 		/* If echoing is enabled and there is output buffer
 		 * space, echo the received character back to the UART.
 		 * (If there is no output buffer space, characters
@@ -274,30 +446,37 @@ ISR(USART0_RX_vect)
 		uart_put_char(c, 0);
 	}
 	
+	/* If the character is a carriage return, turn it into a
+	 * linefeed 
+	*/
+	if (c == '\r') {
+		c = '\n';
+	}
+	
+	/* If someone else wants the input, hand it over rather than
+	 * buffering it.
+	 */
+	if(input_handler) {
+		input_handler(c);
+		return;
+	}
+	
 	/* 
 	 * Check if we have space in our buffer. If not, set the overrun
 	 * flag and throw away the character. (We never clear the 
 	 * overrun flag - it's up to the programmer to check/clear
 	 * this flag if desired.)
 	 */
-	if(bytes_in_input_buffer >= INPUT_BUFFER_SIZE) {
+	uint8_t head = input_head;
+	uint8_t next = (head + 1) & INPUT_BUFFER_MASK;
+	if(next == input_tail) {
 		input_overrun = 1;
 	} else {
-		/* If the character is a carriage return, turn it into a
-		 * linefeed 
-		*/
-		if (c == '\r') {
-			c = '\n';
-		}
-		
 		/* 
-		 * There is room in the input buffer 
+		 * There is room in the input buffer - store the character
+		 * before moving the head past it
 		 */
-		input_buffer[input_insert_pos++] = c;
-		bytes_in_input_buffer++;
-		if(input_insert_pos == INPUT_BUFFER_SIZE) {
-			/* Wrap around buffer pointer if necessary */
-			input_insert_pos = 0;
-		}
+		input_buffer[head] = c;
+		input_head = next;
 	}
 }
@@ -18,13 +18,40 @@
 
 #include <stdint.h>
 
+/* Largest baud rate error we accept, in tenths of a percent. The
+ * datasheet recommends at most 2% for 8 data bits, but that assumes the
+ * other end has its own error - a PC's UART is close to exact, so 2.5%
+ * still works and lets 57600 (2.1% off at 8MHz) through. 115200 is
+ * 3.5% off at 8MHz and is refused.
+ */
+#define MAX_BAUD_ERROR 25
+
 /* Initialise serial IO using the UART. baudrate specifies the desired
  * baudrate (e.g. 19200) and echo determines whether incoming characters
  * are echoed back to the UART output as they are received (zero means no
- * echo, non-zero means echo)
+ * echo, non-zero means echo). If baudrate can't be made accurately
+ * enough (see set_serial_baud()) 19200 is used instead.
  */
 void init_serial_stdio(long baudrate, int8_t echo);
 
+/* Change the baud rate. The divisor (and whether to use double speed
+ * mode) is chosen to get as close to baudrate as possible. Returns 0 if
+ * that's within 2.5% of baudrate, otherwise returns -1 and leaves the
+ * rate unchanged. At 8MHz 19200, 38400, 57600, 76800, 125000 and 250000
+ * are all fine but 115200 is not. Anything still being sent is garbled,
+ * so wait for serial_output_idle() first.
+ */
+int8_t set_serial_baud(long baudrate);
+
+/* Return the baud rate last set.
+ */
+long get_serial_baud(void);
+
+/* Return non-zero if all output has been sent, including the last
+ * character in the UART itself, 0 otherwise.
+ */
+uint8_t serial_output_idle(void);
+
 /* Test if input is available from the serial port. Return 0 if not,
  * non-zero otherwise. If there is input available then it can be read
  * with a suitable standard IO library function, e.g. fgetc().
@@ -36,4 +63,60 @@ int8_t serial_input_available(void);
  */
 void clear_serial_input_buffer(void);
 
+/* Return the number of characters queued for output since
+ * init_serial_stdio() was called (including the \r sent before each
+ * \n). Sampling this periodically gives the output rate.
+ */
+uint32_t get_serial_output_count(void);
+
+/* Return the number of characters that can be output without waiting
+ * for the output buffer to drain.
+ */
+uint8_t serial_output_space(void);
+
+/* Output up to length characters from data without waiting. Returns
+ * the number of characters accepted, which is less than length if the
+ * output buffer filled up. Unlike stdio output, \n is sent as is.
+ */
+uint8_t serial_write(const char* data, uint8_t length);
+
+/* As serial_write() but for a string in program memory (e.g. made with
+ * PSTR()). Stops at the end of the string or when the output buffer is
+ * full and returns the number of characters accepted.
+ */
+uint8_t serial_write_P(const char* data);
+
+/* Install a function to be called (from the receive interrupt handler)
+ * with each character received. While a handler is installed, received
+ * characters are passed to it instead of being buffered for stdin.
+ * Pass 0 to go back to buffering. The handler runs with interrupts
+ * disabled so it must be short.
+ */
+void set_serial_input_handler(void (*handler)(char));
+
+/* Install a function to be called (from the receive interrupt handler)
+ * with every byte received, before echo, CR translation or the input
+ * handler above. It can pass bytes on to serial_receive_char() to have
+ * them handled as usual. Pass 0 to remove it.
+ */
+void set_serial_raw_input_handler(void (*handler)(char));
+
+/* Receive a character as if it had just arrived: echo it if echo is
+ * on, turn CR into LF and then pass it to the input handler or buffer
+ * it for stdin. Only call from the raw input handler.
+ */
+void serial_receive_char(char c);
+
+/* Install a function the transmit interrupt handler calls for the next
+ * byte to send whenever the output buffer is empty. It returns the
+ * byte, or -1 if it has nothing to send. Call start_serial_output()
+ * whenever it gets something new to send. Pass 0 to remove it.
+ */
+void set_serial_output_source(int16_t (*source)(void));
+
+/* Make sure the transmit interrupt is enabled, so it sends anything in
+ * the output buffer or from the output source.
+ */
+void start_serial_output(void);
+
 #endif /* SERIALIO_H_ */
\ No newline at end of file
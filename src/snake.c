@@ -14,6 +14,8 @@
 #include "superFood.h"
 #include "rat.h"
 #include "tron.h"
+#include "timer0.h"
+#include "state_hash.h"
 
 #define SNAKE_POSITION_ARRAY_SIZE ((MAX_SNAKE_SIZE)+1)
 
@@ -58,15 +60,33 @@ static uint8_t snakeLength;
 static int8_t snakeHeadIndex;
 static int8_t snakeTailIndex;
 
-/* curSnakeDirn and nextSnakeDirn
+/* curSnakeDirn
 ** 
-** Variables to keep track of the current direction 
-** of the snake and the proposed next direction of
-** the snake. The "next direction" will take effect
-** when the snake is moved.
+** Variable to keep track of the current direction 
+** of the snake.
 */
 static SnakeDirnType curSnakeDirn;
-static SnakeDirnType nextSnakeDirn;
+
+/* turnQueue, turnTimes, turnQueueStart and turnQueueLength
+**
+** Turns requested since the last move, oldest first, stored
+** in a circular buffer. Each move takes at most one turn from
+** the queue, so two quick presses between moves (e.g. up then
+** left while moving right) become two turns on consecutive moves
+** rather than the second overwriting the first. turnTimes holds
+** the clock ticks (lower 16 bits) when each turn was queued.
+*/
+#define TURN_QUEUE_SIZE 4
+static SnakeDirnType turnQueue[TURN_QUEUE_SIZE];
+static uint16_t turnTimes[TURN_QUEUE_SIZE];
+static uint8_t turnQueueStart;
+static uint8_t turnQueueLength;
+
+/* turnStats
+**
+** How many turns were queued or discarded since init_snake().
+*/
+static TurnStats turnStats;
 
 /* FUNCTIONS */
 /* init_snake()
@@ -85,7 +105,13 @@ void init_snake(void) {
 	snakePositions[0] = position(1,1);
 	snakePositions[1] = position(2,1);
 	curSnakeDirn = SNAKE_RIGHT;
-    nextSnakeDirn = SNAKE_RIGHT;
+	turnQueueStart = 0;
+	turnQueueLength = 0;
+	turnStats.queued = 0;
+	turnStats.reversed = 0;
+	turnStats.overflowed = 0;
+	turnStats.taken = 0;
+	turnStats.waited = 0;
 }
 
 /* get_snake_head_position()
@@ -112,6 +138,46 @@ uint8_t get_snake_length(void) {
 	return snakeLength;
 }
 
+/* get_snake_position()
+**
+** Returns the position index places from the tail.
+*/
+PosnType get_snake_position(uint8_t index) {
+	return snakePositions[(snakeTailIndex + index) % SNAKE_POSITION_ARRAY_SIZE];
+}
+
+/* get_snake_dirn()
+**
+** Returns the current direction of the snake.
+*/
+SnakeDirnType get_snake_dirn(void) {
+	return curSnakeDirn;
+}
+
+/* restore_snake()
+**
+** Make the snake just its tail, ready for extend_snake().
+*/
+void restore_snake(PosnType tail, SnakeDirnType dirn) {
+	snakeLength = 1;
+	snakeTailIndex = 0;
+	snakeHeadIndex = 0;
+	snakePositions[0] = tail;
+	curSnakeDirn = dirn;
+	turnQueueStart = 0;
+	turnQueueLength = 0;
+}
+
+/* extend_snake()
+**
+** Add a new head position without any checks.
+*/
+void extend_snake(PosnType posn) {
+	snakeHeadIndex++;
+	snakePositions[snakeHeadIndex] = posn;
+	snakeLength++;
+}
+
 /* advance_snake_head()
 **
 ** Attempt to move snake head forward. Returns
@@ -136,16 +202,25 @@ int8_t advance_snake_head(void) {
 		return SNAKE_LENGTH_ERROR;
 	}
     
+	/* Take the oldest queued turn (if any) - one turn per move */
+	if(turnQueueLength > 0) {
+		curSnakeDirn = turnQueue[turnQueueStart];
+		turnStats.taken++;
+		turnStats.waited += (uint16_t)get_clock_ticks() - turnTimes[turnQueueStart];
+		turnQueueStart = (turnQueueStart + 1) % TURN_QUEUE_SIZE;
+		turnQueueLength--;
+	}
+    
 	/* Current head position */
 	headX = x_position(snakePositions[snakeHeadIndex]);
 	headY = y_position(snakePositions[snakeHeadIndex]);
     
     /* Work out where the new head position should be - we
-    ** move 1 position in our NEXT direction of movement if we can.
+    ** move 1 position in our current direction of movement if we can.
 	** If we're at the edge of the board, then we wrap around to
 	** the other edge.
     */
-    switch (nextSnakeDirn) {
+    switch (curSnakeDirn) {
         case SNAKE_UP:
 			if(headY == BOARD_HEIGHT - 1) {
 				// Head is already at the top of the board - wrap around
@@ -181,9 +256,6 @@ int8_t advance_snake_head(void) {
 
 	newHeadPosn = position(headX, headY);
 
-	/* Update the current direction */
-	curSnakeDirn = nextSnakeDirn;
-
 	/* ADD CODE HERE to check whether the new head position
 	** is already occupied by the snake (other than the tail), and if so, return
 	** COLLISION. Do not continue. See snake.h for a function which can help you.
@@ -198,7 +270,7 @@ int8_t advance_snake_head(void) {
 	//for level 3 advance feature, tron mode
 	if (is_tron_mode()) {
 		if (is_tron_at(newHeadPosn)) {
-			return COLLISION;
+			return TRON_COLLISION;
 		}
 	}
 
@@ -209,13 +281,16 @@ int8_t advance_snake_head(void) {
 	** and whether this has wrapped around in our array of positions
 	** or not. Update the length.
     */
+	toggle_state_hash(HASH_SNAKE_HEAD, snakePositions[snakeHeadIndex]);
 	snakeHeadIndex++;
 	if(snakeHeadIndex == SNAKE_POSITION_ARRAY_SIZE) {
 		/* Array has wrapped around */
 		snakeHeadIndex = 0;
 	}
-	/* Store the head position */
+	/* Store the head position, and move the head in the hash */
 	snakePositions[snakeHeadIndex] = newHeadPosn;
+	toggle_state_hash(HASH_SNAKE, newHeadPosn);
+	toggle_state_hash(HASH_SNAKE_HEAD, newHeadPosn);
 	/* Update the snake's length */
 	snakeLength++;
 	
@@ -266,6 +341,7 @@ int8_t advance_snake_head(void) {
 PosnType advance_snake_tail(void) {
 	// Get the current tail position
 	PosnType prev_tail_position = snakePositions[snakeTailIndex];
+	toggle_state_hash(HASH_SNAKE, prev_tail_position);
 	
 	/* Update the tail index */
 	snakeTailIndex++;
@@ -279,25 +355,40 @@ PosnType advance_snake_tail(void) {
 }
 
 /* set_snake_dirn
-**      Attempt to set the next snake direction.
-**      (Should be ignored if try and reverse snake from its current
-**      direction, but otherwise the direction will be accepted.)
-**      It's OK to continue in same direction or turn 90 degrees.
+**      Attempt to queue a turn in the given direction.
+**      (Ignored if it would reverse the snake from the direction
+**      it will be heading in once the turns already queued are
+**      taken, but otherwise the turn is queued.)
+**      Asking for the direction already being headed in does nothing.
 */
 void set_snake_dirn(SnakeDirnType dirn) {
-	/* YOUR CODE HERE - MODIFY THIS FUNCTION */
-	/* You must write code to check that the proposed direction (dirn)
-	** is not opposite to the current direction (stored in curSnakeDirn). 
-	**
-	** Initially, we assume the move is OK and just set the 
-	** next direction.
-	*/
-    if ((curSnakeDirn == SNAKE_UP && dirn != SNAKE_DOWN) ||
-        (curSnakeDirn == SNAKE_DOWN && dirn != SNAKE_UP) ||
-        (curSnakeDirn == SNAKE_LEFT && dirn != SNAKE_RIGHT) ||
-        (curSnakeDirn == SNAKE_RIGHT && dirn != SNAKE_LEFT)) {
-            nextSnakeDirn = dirn;
-        }
+	SnakeDirnType lastDirn = curSnakeDirn;
+	if(turnQueueLength > 0) {
+		lastDirn = turnQueue[(turnQueueStart + turnQueueLength - 1) % TURN_QUEUE_SIZE];
+	}
+	if(dirn == lastDirn) {
+		return;
+	}
+	/* Directions go clockwise, so opposite directions are 2 apart */
+	if(dirn == (lastDirn + 2) % 4) {
+		turnStats.reversed++;
+		return;
+	}
+	if(turnQueueLength >= TURN_QUEUE_SIZE) {
+		turnStats.overflowed++;
+		return;
+	}
+	turnQueue[(turnQueueStart + turnQueueLength) % TURN_QUEUE_SIZE] = dirn;
+	turnTimes[(turnQueueStart + turnQueueLength) % TURN_QUEUE_SIZE] = get_clock_ticks();
+	turnQueueLength++;
+	turnStats.queued++;
+}
+
+/* get_turn_stats
+**      Copy the turn counters into *stats.
+*/
+void get_turn_stats(TurnStats* stats) {
+	*stats = turnStats;
 }
 
 /* is_snake_at
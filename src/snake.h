@@ -18,10 +18,20 @@
 /* Directions */
 typedef enum {SNAKE_UP, SNAKE_RIGHT, SNAKE_DOWN, SNAKE_LEFT} SnakeDirnType;
 
+/* Counts of turns requested with set_snake_dirn() */
+typedef struct {
+	uint16_t queued;		/* accepted into the turn queue */
+	uint16_t reversed;		/* discarded - would reverse the snake */
+	uint16_t overflowed;	/* discarded - turn queue was full */
+	uint16_t taken;			/* taken from the queue by a move */
+	uint32_t waited;		/* total ms from queueing to being taken */
+} TurnStats;
+
 /* Possible results of an attempt to move the snake */
 #define OUT_OF_BOUNDS -1
 #define COLLISION -2
 #define SNAKE_LENGTH_ERROR -3
+#define TRON_COLLISION -4
 #define MOVE_OK 1
 #define ATE_FOOD 2
 #define ATE_FOOD_BUT_CANT_GROW 3
@@ -62,13 +72,44 @@ PosnType get_snake_tail_position(void);
 */
 uint8_t get_snake_length(void);
 
+/* get_snake_position(index)
+**
+** Returns the position of the snake index places from its tail
+** (0 is the tail, get_snake_length()-1 is the head).
+*/
+PosnType get_snake_position(uint8_t index);
+
+/* get_snake_dirn()
+**
+** Returns the direction the snake last moved in (or will first
+** move in, if it hasn't moved yet). Queued turns aren't included.
+*/
+SnakeDirnType get_snake_dirn(void);
+
+/* restore_snake(tail, direction)
+**
+** Start rebuilding a snake saved earlier. The snake becomes just
+** the given tail position, heading in the given direction with
+** no turns queued. Each extend_snake() call then adds the next
+** position towards the head. Nothing is displayed.
+*/
+void restore_snake(PosnType tail, SnakeDirnType dirn);
+
+/* extend_snake(position)
+**
+** Add a position to the head end of a snake being rebuilt with
+** restore_snake(). The snake must be shorter than MAX_SNAKE_SIZE.
+*/
+void extend_snake(PosnType posn);
+
 /* advance_snake_head()
 **
-** Attempt to advance the snake's head by one in the 
-** most recently set direction.
+** Attempt to advance the snake's head by one, after taking
+** the oldest queued turn (if any).
 ** Returns -1 (OUT_OF_BOUNDS) if the snake has run into the
 ** edge, -2 (COLLISION) if the snake has run into itself,
 ** -3 (SNAKE_LENGTH_ERROR) if the snake length is invalid,
+** -4 (TRON_COLLISION) if the snake has run into the Tron,
 ** 1 (MOVE_OK) if the move is successful, 2 (ATE_FOOD)
 ** if the snake has eaten some food and can grow in size, 
 ** 3 (ATE_FOOD_BUT_CANT_GROW) if the snake has eaten some food
@@ -92,16 +133,22 @@ PosnType advance_snake_tail();
 
 /* set_snake_dirn(direction)
 **
-** Attempt to set snake direction.
-** (Should be ignored if try and reverse snake - OK to continue
-** in same direction or turn 90 degrees. Initial code will just
-** accept any direction.) The direction
-** will take effect when the snake head is moved. This
-** function can be called multiple times - only the last
-** value set before the snake is moved will be used.
+** Attempt to turn the snake. Turns are queued and each move of
+** the snake head takes one, so several turns made between two
+** moves all take effect, one per move. A turn is checked against
+** the last queued turn (or the current direction if none are
+** queued): reversing is ignored, as is asking for the same
+** direction. Turns are also dropped if the queue is full.
 */
 void set_snake_dirn(SnakeDirnType dirn);
 
+/* get_turn_stats(stats)
+**
+** Copy the number of turns queued and discarded since the
+** snake was initialised into *stats.
+*/
+void get_turn_stats(TurnStats* stats);
+
 /* is_snake_at(position)
 **
 ** Returns 1 if the given position is occupied by 
@@ -0,0 +1,240 @@
+/*
+** snapshot.c
+**
+** Written by Arda Akgur
+**
+** The snapshot is a byte stream:
+**   version, flags, score (4 bytes), speed in hundredths (2 bytes),
+**   game time (4 bytes), random number generator state (2 bytes),
+**   time since the snake, rat and super food timers (2 bytes each),
+**   rat position, super food position,
+**   number of food items and their positions,
+**   the snake, then the Tron if Tron mode is on.
+** A snake (or Tron) is its length, its direction, its tail position
+** and then the direction of each step from the tail to the head,
+** packed two bits each. Positions are already one byte each.
+** Multi-byte values are stored low byte first. At its largest (32
+** long snake and Tron, 8 food items) it is 53 bytes.
+*/
+
+#include "snapshot.h"
+#include "journal.h"
+#include "eeprom_writer.h"
+#include "board.h"
+#include "position.h"
+#include "snake.h"
+#include "tron.h"
+#include "food.h"
+#include "rat.h"
+#include "superFood.h"
+#include "score.h"
+#include "game.h"
+#include "prng.h"
+#include "state_hash.h"
+
+// Bump this when the layout changes
+#define SNAPSHOT_VERSION 3
+
+// flags
+#define SNAPSHOT_TRON 0x01
+#define SNAPSHOT_SUPER_FOOD 0x02
+
+// bytes taken by a snake of the given length
+#define BODY_SIZE(length) (3 + ((length) + 3) / 4)
+
+#define SNAPSHOT_SIZE (23 + MAX_FOOD + 2 * BODY_SIZE(MAX_SNAKE_SIZE))
+
+_Static_assert(SNAPSHOT_SIZE <= JOURNAL_MAX_DATA, "snapshot doesn't fit in a journal record");
+
+// the record being written or read
+static uint8_t snapshot[SNAPSHOT_SIZE];
+
+// position reached in the record
+static uint8_t cursor;
+
+typedef PosnType (*GetBodyPosition)(uint8_t index);
+typedef void (*RestoreBody)(PosnType tail, SnakeDirnType dirn);
+typedef void (*ExtendBody)(PosnType posn);
+
+static void put_byte(uint8_t value) {
+	snapshot[cursor++] = value;
+}
+
+static void put_word(uint16_t value) {
+	put_byte(value & 0xFF);
+	put_byte(value >> 8);
+}
+
+static uint8_t get_byte(void) {
+	return snapshot[cursor++];
+}
+
+static uint16_t get_word(void) {
+	uint16_t value = get_byte();
+	return value | (get_byte() << 8);
+}
+
+// time from then until now, at most 0xFFFF
+static uint16_t time_since(uint32_t now, uint32_t then) {
+	return now - then > 0xFFFF ? 0xFFFF : now - then;
+}
+
+// time the given amount before now, or 0 if that's before the clock
+// started
+static uint32_t time_before(uint32_t now, uint16_t time) {
+	return now > time ? now - time : 0;
+}
+
+// direction of a step from one position to the next, going over the
+// edge of the board if needed
+static SnakeDirnType step_dirn(PosnType from, PosnType to) {
+	uint8_t dx = (x_position(to) + BOARD_WIDTH - x_position(from)) % BOARD_WIDTH;
+	uint8_t dy = (y_position(to) + BOARD_HEIGHT - y_position(from)) % BOARD_HEIGHT;
+	if (dx == 1) {
+		return SNAKE_RIGHT;
+	} else if (dx == BOARD_WIDTH - 1) {
+		return SNAKE_LEFT;
+	} else if (dy == 1) {
+		return SNAKE_UP;
+	}
+	return SNAKE_DOWN;
+}
+
+// position one step from the given one
+static PosnType step_posn(PosnType from, SnakeDirnType dirn) {
+	uint8_t x = x_position(from);
+	uint8_t y = y_position(from);
+	switch (dirn) {
+		case SNAKE_UP:
+			y = (y + 1) % BOARD_HEIGHT;
+			break;
+		case SNAKE_RIGHT:
+			x = (x + 1) % BOARD_WIDTH;
+			break;
+		case SNAKE_DOWN:
+			y = (y + BOARD_HEIGHT - 1) % BOARD_HEIGHT;
+			break;
+		case SNAKE_LEFT:
+			x = (x + BOARD_WIDTH - 1) % BOARD_WIDTH;
+			break;
+	}
+	return position(x, y);
+}
+
+static void put_body(uint8_t length, SnakeDirnType dirn, GetBodyPosition get_position) {
+	uint8_t packed = 0;
+	uint8_t i;
+	put_byte(length);
+	put_byte(dirn);
+	put_byte(get_position(0));
+	for (i = 1; i < length; i++) {
+		packed |= step_dirn(get_position(i - 1), get_position(i)) << (2 * (i % 4));
+		if (i % 4 == 3 || i == length - 1) {
+			put_byte(packed);
+			packed = 0;
+		}
+	}
+}
+
+static void get_body(RestoreBody restore, ExtendBody extend) {
+	uint8_t length = get_byte();
+	SnakeDirnType dirn = get_byte();
+	PosnType posn = get_byte();
+	uint8_t packed = 0;
+	uint8_t i;
+	restore(posn, dirn);
+	for (i = 1; i < length; i++) {
+		if (i == 1 || i % 4 == 0) {
+			packed = get_byte();
+		}
+		posn = step_posn(posn, (packed >> (2 * (i % 4))) & 0x03);
+		extend(posn);
+	}
+}
+
+void save_snapshot(uint32_t last_move_time, uint32_t rat_move_time) {
+	uint32_t now = get_game_time();
+	uint8_t flags = 0;
+	uint32_t score = get_score();
+	int8_t i;
+	
+	// the last snapshot is written straight from our buffer
+	while (is_eeprom_writing()) {
+		;
+	}
+	if (is_tron_mode()) {
+		flags |= SNAPSHOT_TRON;
+	}
+	if (is_there_super_food()) {
+		flags |= SNAPSHOT_SUPER_FOOD;
+	}
+	cursor = 0;
+	put_byte(SNAPSHOT_VERSION);
+	put_byte(flags);
+	put_word(score & 0xFFFF);
+	put_word(score >> 16);
+	put_word(get_game_speed() * 100 + 0.5);
+	put_word(now & 0xFFFF);
+	put_word(now >> 16);
+	put_word(get_prng_state());
+	put_word(time_since(now, last_move_time));
+	put_word(time_since(now, rat_move_time));
+	put_word(time_since(now, get_super_food_timer()));
+	put_byte(get_position_of_rat());
+	put_byte(get_position_of_super_food());
+	put_byte(get_num_food_items());
+	for (i = 0; i < get_num_food_items(); i++) {
+		put_byte(get_position_of_food(i));
+	}
+	put_body(get_snake_length(), get_snake_dirn(), get_snake_position);
+	if (flags & SNAPSHOT_TRON) {
+		put_body(get_tron_length(), get_tron_dirn(), get_tron_position);
+	}
+	append_journal(JOURNAL_SNAPSHOT, snapshot, cursor);
+}
+
+void clear_snapshot(void) {
+	append_journal(JOURNAL_SNAPSHOT, snapshot, 0);
+}
+
+uint8_t is_snapshot_saved(void) {
+	return read_journal(JOURNAL_SNAPSHOT, snapshot, sizeof(snapshot)) > 0
+			&& snapshot[0] == SNAPSHOT_VERSION;
+}
+
+uint8_t load_snapshot(uint32_t* last_move_time, uint32_t* rat_move_time) {
+	uint32_t now;
+	uint8_t flags;
+	uint32_t score;
+	int8_t i;
+	
+	if (!is_snapshot_saved()) {
+		return 0;
+	}
+	cursor = 1;
+	flags = get_byte();
+	score = get_word();
+	score |= (uint32_t)get_word() << 16;
+	set_score(score);
+	set_game_speed(get_word() / 100.0);
+	now = get_word();
+	now |= (uint32_t)get_word() << 16;
+	set_game_time(now);
+	set_prng_state(get_word());
+	*last_move_time = time_before(now, get_word());
+	*rat_move_time = time_before(now, get_word());
+	set_super_food_timer(time_before(now, get_word()));
+	set_rat_pos(get_byte());
+	restore_super_food(get_byte(), (flags & SNAPSHOT_SUPER_FOOD) != 0);
+	init_food();
+	for (i = get_byte(); i > 0; i--) {
+		restore_food_item(get_byte());
+	}
+	get_body(restore_snake, extend_snake);
+	if (flags & SNAPSHOT_TRON) {
+		get_body(restore_tron, extend_tron);
+	}
+	set_tron_mode((flags & SNAPSHOT_TRON) != 0);
+	reset_state_hash();
+	return 1;
+}
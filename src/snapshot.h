@@ -0,0 +1,50 @@
+/*
+** snapshot.h
+**
+** Written by Arda Akgur
+**
+** Saving a game in progress so it can be carried on after a reset.
+** The whole game state (snake, Tron, food, rat, super food, score,
+** speed, game time, random state and the time since each timed
+** event) is packed into one small journal record (see journal.h).
+** The game is saved when it is paused and the save is cleared when
+** it carries on, so turning the board off while paused picks up the
+** same game at the next power on.
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <inttypes.h>
+
+/* save_snapshot(last_move_time, rat_move_time)
+**
+** Start saving the current game. The last snake and rat move times
+** (game time) are saved as times before now. Waits first if an
+** earlier snapshot is still being written.
+*/
+void save_snapshot(uint32_t last_move_time, uint32_t rat_move_time);
+
+/* clear_snapshot()
+**
+** Start saving an empty snapshot, so there is no game to carry on.
+*/
+void clear_snapshot(void);
+
+/* is_snapshot_saved()
+**
+** Returns 1 if there is a saved game to carry on, 0 otherwise.
+** init_journal() must be called first.
+*/
+uint8_t is_snapshot_saved(void);
+
+/* load_snapshot(last_move_time, rat_move_time)
+**
+** Restore the saved game, if there is one, including the game time,
+** and set the last snake and rat move times to match. The display isn't updated. Returns 1
+** if a game was restored, 0 otherwise (and nothing is changed).
+*/
+uint8_t load_snapshot(uint32_t* last_move_time, uint32_t* rat_move_time);
+
+#endif
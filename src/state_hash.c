@@ -0,0 +1,62 @@
+/*
+** state_hash.c
+**
+** Written by Arda Akgur
+**
+** There isn't room for a table of random keys (6 pieces on 128 cells
+** would be 3KB), so each key is made when needed by mixing the piece
+** and position with the finaliser from MurmurHash3. Different inputs
+** always give different keys and every bit of the input changes about
+** half the bits of the key. A key costs two 32 bit multiplies, and a
+** snake move needs three or four keys.
+*/
+
+#include "state_hash.h"
+#include "snake.h"
+#include "tron.h"
+#include "food.h"
+#include "rat.h"
+#include "superFood.h"
+
+static uint32_t state_hash;
+
+// the key for the given piece at the given position. The input is
+// never 0, which is the one input that mixes to a key of 0 - and its
+// top half is always 0 so the finaliser's first step is left out.
+static uint32_t zobrist_key(HashPiece piece, PosnType posn) {
+	uint32_t key = ((uint16_t)(piece + 1) << 8) | posn;
+	key *= 0x85EBCA6BUL;
+	key ^= key >> 13;
+	key *= 0xC2B2AE35UL;
+	key ^= key >> 16;
+	return key;
+}
+
+void toggle_state_hash(HashPiece piece, PosnType posn) {
+	state_hash ^= zobrist_key(piece, posn);
+}
+
+void reset_state_hash(void) {
+	uint8_t i;
+	state_hash = 0;
+	for (i = 0; i < get_snake_length(); i++) {
+		toggle_state_hash(HASH_SNAKE, get_snake_position(i));
+	}
+	toggle_state_hash(HASH_SNAKE_HEAD, get_snake_head_position());
+	if (is_tron_mode()) {
+		for (i = 0; i < get_tron_length(); i++) {
+			toggle_state_hash(HASH_TRON, get_tron_position(i));
+		}
+	}
+	for (i = 0; i < get_num_food_items(); i++) {
+		toggle_state_hash(HASH_FOOD, get_position_of_food(i));
+	}
+	toggle_state_hash(HASH_RAT, get_position_of_rat());
+	if (is_there_super_food()) {
+		toggle_state_hash(HASH_SUPER_FOOD, get_position_of_super_food());
+	}
+}
+
+uint32_t get_state_hash(void) {
+	return state_hash;
+}
@@ -0,0 +1,51 @@
+/*
+** state_hash.h
+**
+** Written by Arda Akgur
+**
+** A 32 bit Zobrist hash of what is on the board - the snake (and
+** which cell is its head), the Tron while Tron mode is on, the food,
+** the rat and the super food. Each piece at each cell has its own key
+** and the hash is all the keys of the pieces on the board XORed
+** together, so a piece appearing or leaving only XORs in one key. The
+** modules that move pieces keep it up to date as they go, so two runs
+** of a game (e.g. a game and its replay) are in step exactly when
+** their hashes match after each move.
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef STATE_HASH_H_
+#define STATE_HASH_H_
+
+#include <inttypes.h>
+#include "position.h"
+
+typedef enum {
+	HASH_SNAKE,		// every cell of the snake, head included
+	HASH_SNAKE_HEAD,
+	HASH_TRON,
+	HASH_FOOD,
+	HASH_RAT,
+	HASH_SUPER_FOOD
+} HashPiece;
+
+/* toggle_state_hash(piece, position)
+**
+** Add or remove (they are the same) a piece at a board position.
+*/
+void toggle_state_hash(HashPiece piece, PosnType posn);
+
+/* reset_state_hash()
+**
+** Work the hash out from scratch, for when the whole board has been
+** set up at once (a new game or a restored snapshot).
+*/
+void reset_state_hash(void);
+
+/* get_state_hash()
+**
+** Returns the hash of the board as it is now.
+*/
+uint32_t get_state_hash(void);
+
+#endif
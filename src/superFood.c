@@ -11,6 +11,8 @@
 #include "superFood.h"
 #include "tron.h"
 #include "rat.h"
+#include "prng.h"
+#include "state_hash.h"
 
 // instance variables
 static PosnType superFoodPosition;
@@ -37,6 +39,7 @@ uint8_t is_there_super_food(void) {
 /* Flips the superFood
 */
 void reverse_super_food(void) {
+	toggle_state_hash(HASH_SUPER_FOOD, superFoodPosition);
     if (superFood == 0) {
         superFood = 1;
     } else {
@@ -50,19 +53,16 @@ void reverse_super_food(void) {
 */
 PosnType add_super_food_item(void) {
 
-	/* Generate "random" positions until we get one which
+	/* Generate random positions until we get one which
 	** is not occupied by a snake or food.
 	*/
 	int8_t x, y, attempts;
 	PosnType test_position;
-	x = 0;
-	y = 0;
 	attempts = 0;
 	do {
-		// Generate a new position - this is based on a sequence rather
-		// then being random
-        x = (x+3+attempts)%BOARD_WIDTH;
-        y = (y+5)%BOARD_HEIGHT;
+		// Generate a new random position
+        x = random_below(BOARD_WIDTH);
+        y = random_below(BOARD_HEIGHT);
 		test_position = position(x,y);
         attempts++;
     } while(attempts < 100 && 
@@ -89,3 +89,10 @@ PosnType add_super_food_item(void) {
 PosnType get_position_of_super_food(void) {
 	return superFoodPosition;
 }
+
+/* Sets the SuperFood position and whether it is in the game
+*/
+void restore_super_food(PosnType posn, uint8_t active) {
+	superFoodPosition = posn;
+	superFood = active;
+}
@@ -29,5 +29,8 @@ PosnType add_super_food_item(void);
 // returns the current positon of super food
 PosnType get_position_of_super_food(void);
 
+// puts the super food at the given position, and in the game or not
+void restore_super_food(PosnType posn, uint8_t active);
+
 
 #endif
@@ -0,0 +1,228 @@
+/*
+** telemetry.c
+**
+** Written by Arda Akgur
+**
+** Binary telemetry packets. Item changes are found by comparing the
+** board with a copy of where the items were when the last packet was
+** sent, so the game code doesn't need to report them. Packets are
+** only sent if they fit in the serial output buffer - a dropped packet
+** makes the next one a keyframe.
+*/
+
+#include <util/crc16.h>
+#include "telemetry.h"
+#include "board.h"
+#include "position.h"
+#include "snake.h"
+#include "food.h"
+#include "rat.h"
+#include "superFood.h"
+#include "score.h"
+#include "channel.h"
+
+// big enough for a keyframe with MAX_FOOD food items
+#define MAX_PACKET_SIZE (3 + BOARD_WIDTH + 7 + MAX_FOOD + 1)
+
+static uint8_t telemetry_on;
+static uint8_t sequence;
+static uint8_t moves_since_keyframe;
+static uint8_t keyframe_due;
+static TelemetryStats stats;
+
+// items as at the last packet - food as a bitmap like the snake's
+static uint8_t sent_food[BOARD_WIDTH];
+static PosnType sent_rat;
+static PosnType sent_super_food;
+
+// packet being built and its CRC so far
+static uint8_t packet[MAX_PACKET_SIZE];
+static uint8_t packet_length;
+static uint8_t crc;
+
+static void begin_packet(uint8_t type) {
+	packet[0] = TELEMETRY_SYNC;
+	packet[1] = type;
+	packet[2] = sequence;
+	packet_length = 3;
+	crc = _crc8_ccitt_update(0, type);
+	crc = _crc8_ccitt_update(crc, sequence);
+}
+
+static void put(uint8_t value) {
+	packet[packet_length++] = value;
+	crc = _crc8_ccitt_update(crc, value);
+}
+
+static void put_score(void) {
+	uint16_t score = get_score();
+	put(score & 0xFF);
+	put(score >> 8);
+}
+
+// sends the packet if it all fits, returns 0 if it was dropped
+static uint8_t end_packet(void) {
+	packet[packet_length++] = crc;
+	if (channel_space(CHANNEL_TELEMETRY) < packet_length) {
+		stats.dropped++;
+		keyframe_due = 1;
+		return 0;
+	}
+	channel_write(CHANNEL_TELEMETRY, (const char*)packet, packet_length);
+	sequence++;
+	stats.packets++;
+	stats.bytes += packet_length;
+	return 1;
+}
+
+static PosnType rat_position(void) {
+	PosnType posn = get_position_of_rat();
+	return is_position_valid(posn) ? posn : INVALID_POSITION;
+}
+
+static PosnType super_food_position(void) {
+	return is_there_super_food() ? get_position_of_super_food() : INVALID_POSITION;
+}
+
+static void send_keyframe(void) {
+	uint8_t x, y, column;
+	uint8_t food_count = 0;
+	PosnType food[MAX_FOOD];
+	
+	begin_packet(TELEMETRY_KEYFRAME);
+	for (x = 0; x < BOARD_WIDTH; x++) {
+		column = 0;
+		sent_food[x] = 0;
+		for (y = 0; y < BOARD_HEIGHT; y++) {
+			if (is_snake_at(position(x, y))) {
+				column |= 1 << y;
+			}
+			if (is_food_at(position(x, y)) && food_count < MAX_FOOD) {
+				sent_food[x] |= 1 << y;
+				food[food_count++] = position(x, y);
+			}
+		}
+		put(column);
+	}
+	sent_rat = rat_position();
+	sent_super_food = super_food_position();
+	put(get_snake_head_position());
+	put(get_snake_tail_position());
+	put(sent_rat);
+	put(sent_super_food);
+	put_score();
+	put(food_count);
+	for (x = 0; x < food_count; x++) {
+		put(food[x]);
+	}
+	if (end_packet()) {
+		keyframe_due = 0;
+		moves_since_keyframe = 0;
+		stats.keyframes++;
+	}
+}
+
+void set_telemetry(uint8_t on) {
+	telemetry_on = on;
+	keyframe_due = 1;
+}
+
+uint8_t is_telemetry_on(void) {
+	return telemetry_on;
+}
+
+void start_telemetry(void) {
+	stats.packets = 0;
+	stats.keyframes = 0;
+	stats.dropped = 0;
+	stats.bytes = 0;
+	keyframe_due = 1;
+	if (telemetry_on) {
+		send_keyframe();
+	}
+}
+
+void send_telemetry_tick(void) {
+	uint8_t x, y, column, changes;
+	uint8_t kinds[TELEMETRY_MAX_ITEM_CHANGES];
+	PosnType posns[TELEMETRY_MAX_ITEM_CHANGES];
+	uint8_t food[BOARD_WIDTH];
+	PosnType rat, super_food;
+	
+	if (!telemetry_on) {
+		return;
+	}
+	moves_since_keyframe++;
+	if (keyframe_due || moves_since_keyframe >= TELEMETRY_KEYFRAME_INTERVAL) {
+		send_keyframe();
+		return;
+	}
+	
+	// what changed since the last packet
+	changes = 0;
+	for (x = 0; x < BOARD_WIDTH; x++) {
+		column = 0;
+		for (y = 0; y < BOARD_HEIGHT; y++) {
+			if (is_food_at(position(x, y))) {
+				column |= 1 << y;
+			}
+		}
+		food[x] = column;
+		column ^= sent_food[x];
+		for (y = 0; column; y++, column >>= 1) {
+			if (column & 1) {
+				if (changes == TELEMETRY_MAX_ITEM_CHANGES) {
+					send_keyframe();
+					return;
+				}
+				kinds[changes] = ((food[x] >> y) & 1) ? TELEMETRY_FOOD_ADDED : TELEMETRY_FOOD_REMOVED;
+				posns[changes++] = position(x, y);
+			}
+		}
+	}
+	rat = rat_position();
+	super_food = super_food_position();
+	if (changes + (rat != sent_rat) + (super_food != sent_super_food) > TELEMETRY_MAX_ITEM_CHANGES) {
+		send_keyframe();
+		return;
+	}
+	if (rat != sent_rat) {
+		kinds[changes] = TELEMETRY_RAT_MOVED;
+		posns[changes++] = rat;
+	}
+	if (super_food != sent_super_food) {
+		kinds[changes] = TELEMETRY_SUPER_FOOD_MOVED;
+		posns[changes++] = super_food;
+	}
+	
+	begin_packet(TELEMETRY_DELTA);
+	put(get_snake_head_position());
+	put(get_snake_tail_position());
+	put_score();
+	put(changes);
+	for (x = 0; x < changes; x++) {
+		put(kinds[x]);
+		put(posns[x]);
+	}
+	if (end_packet()) {
+		for (x = 0; x < BOARD_WIDTH; x++) {
+			sent_food[x] = food[x];
+		}
+		sent_rat = rat;
+		sent_super_food = super_food;
+	}
+}
+
+void send_telemetry_game_over(void) {
+	if (!telemetry_on) {
+		return;
+	}
+	begin_packet(TELEMETRY_GAME_OVER);
+	put_score();
+	end_packet();
+}
+
+void get_telemetry_stats(TelemetryStats* telemetry_stats) {
+	// only changed from the main loop, so no need to stop interrupts
+	*telemetry_stats = stats;
+}
@@ -0,0 +1,102 @@
+/*
+** telemetry.h
+**
+** Written by Arda Akgur
+**
+** Optional binary telemetry over the serial port, in place of the
+** terminal view (or alongside it on its own channel when framing is on
+** - see channel.h). A keyframe with the whole board is sent at the start
+** of a game and every TELEMETRY_KEYFRAME_INTERVAL snake moves, and a
+** small delta after every other move. tools/telemetry decodes the
+** stream on the host.
+**
+** Every packet is
+**   0x7E, type, sequence number, payload..., CRC-8
+** where the CRC-8 (CCITT, initial value 0) covers type to the end of
+** the payload and the sequence number goes up by one per packet.
+** Positions are PosnType values, INVALID_POSITION (0x08) meaning none,
+** and the score is the low 16 bits, least significant byte first.
+**
+** 'K' keyframe: snake bitmap (16 bytes, byte x bit y set if the snake
+**     is at (x, y)), head, tail, rat, super food, score (2 bytes),
+**     number of food items, food positions
+** 'D' delta: head, tail, score (2 bytes), number of item changes,
+**     then a kind and position for each change (see below). The old
+**     tail is cleared before the head is drawn.
+** 'X' game over: score (2 bytes)
+*/
+
+/* Guard band to ensure this definition is only included once */
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <inttypes.h>
+
+#define TELEMETRY_SYNC 0x7E
+
+// Packet types
+#define TELEMETRY_KEYFRAME 'K'
+#define TELEMETRY_DELTA 'D'
+#define TELEMETRY_GAME_OVER 'X'
+
+// Item change kinds in a delta
+#define TELEMETRY_FOOD_ADDED 1
+#define TELEMETRY_FOOD_REMOVED 2
+#define TELEMETRY_RAT_MOVED 3
+#define TELEMETRY_SUPER_FOOD_MOVED 4
+
+// Snake moves between keyframes, so a host that missed a packet
+// doesn't have to wait long
+#define TELEMETRY_KEYFRAME_INTERVAL 32
+
+// Most item changes sent in a delta - a keyframe is sent instead if
+// more than this changed
+#define TELEMETRY_MAX_ITEM_CHANGES 8
+
+typedef struct {
+	uint16_t packets;
+	uint16_t keyframes;
+	uint16_t dropped;	// packets that didn't fit in the output buffer
+	uint32_t bytes;
+} TelemetryStats;
+
+/* set_telemetry(on)
+**
+** Turn telemetry on (1) or off (0). While it's on the terminal view
+** should not be updated.
+*/
+void set_telemetry(uint8_t on);
+
+/* is_telemetry_on()
+**
+** Returns 1 if telemetry is on, 0 otherwise.
+*/
+uint8_t is_telemetry_on(void);
+
+/* start_telemetry()
+**
+** Call when a new game starts. Sends a keyframe if telemetry is on
+** and resets the counters.
+*/
+void start_telemetry(void);
+
+/* send_telemetry_tick()
+**
+** Call after each snake move. Sends a delta, or a keyframe when one
+** is due or the last packet was dropped.
+*/
+void send_telemetry_tick(void);
+
+/* send_telemetry_game_over()
+**
+** Call when the game ends.
+*/
+void send_telemetry_game_over(void);
+
+/* get_telemetry_stats(stats)
+**
+** Copy the counters since start_telemetry() into *stats.
+*/
+void get_telemetry_stats(TelemetryStats* stats);
+
+#endif
@@ -0,0 +1,371 @@
+/*
+ * terminal_view.c
+ *
+ * Written by Arda Akgur
+ */
+
+#include <avr/pgmspace.h>
+#include "terminal_view.h"
+#include "terminalio.h"
+#include "board.h"
+#include "position.h"
+#include "snake.h"
+#include "food.h"
+#include "superFood.h"
+#include "rat.h"
+#include "tron.h"
+#include "score.h"
+#include "channel.h"
+#include "telemetry.h"
+#include "emit.h"
+
+// Where things are on the terminal (column, row - top left is 1, 1).
+// The grid includes the border, board position (x, y) is at
+// column GRID_LEFT + 1 + x and row GRID_TOP + BOARD_HEIGHT - y.
+#define SCORE_LEFT 3
+#define SCORE_TOP 3
+#define SCORE_VALUE_LEFT (SCORE_LEFT + 7)
+#define GRID_LEFT 1
+#define GRID_TOP 7
+#define GRID_WIDTH (BOARD_WIDTH + 2)
+#define GRID_HEIGHT (BOARD_HEIGHT + 2)
+#define TRON_TOP (GRID_TOP + GRID_HEIGHT + 1)
+#define TRON_LINES 4
+#define PAUSE_TOP (TRON_TOP + TRON_LINES + 1)
+
+// What can be shown in a board cell
+typedef enum {
+	CELL_EMPTY, CELL_SNAKE_HEAD, CELL_SNAKE_TAIL, CELL_SNAKE_BODY,
+	CELL_RAT, CELL_FOOD, CELL_SUPER_FOOD,
+	CELL_TRON_HEAD, CELL_TRON_TAIL, CELL_TRON_BODY
+} CellType;
+
+// Character and colour for each CellType
+static const struct {
+	char c;
+	uint8_t colour;	// DisplayParameter
+} cell_looks[] PROGMEM = {
+	{' ', FG_WHITE}, {'H', FG_BLUE}, {'T', FG_BLUE}, {'#', FG_MAGENTA},
+	{'r', FG_GREEN}, {'f', FG_WHITE}, {'s', FG_RED},
+	{'H', FG_CYAN}, {'T', FG_CYAN}, {'@', FG_CYAN}
+};
+
+// Cell types last sent for each board position, indexed [x][y]
+static uint8_t last_frame[BOARD_WIDTH][BOARD_HEIGHT];
+
+// Score, Tron and pause state last shown
+static uint32_t last_score;
+static uint8_t last_tron_mode;
+static uint8_t last_paused;
+
+// Parts of a frame, sent in this order by step_terminal_view().
+// PART_SCREEN is only there after init_terminal_view().
+#define PART_SCREEN 0
+#define PART_CELLS 1
+#define PART_SCORE 2
+#define PART_TRON 3
+#define PART_PAUSE 4
+#define PART_DONE 5
+
+// Progress through the current frame. scan_x and scan_y are the next
+// board position to check, tron_line the next line of the Tron
+// message to draw (TRON_LINES when there is nothing to draw).
+static uint8_t frame_part;
+static uint8_t scan_x;
+static uint8_t scan_y;
+static uint8_t tron_line;
+static uint8_t frame_paused;
+
+// Next piece of the screen set up: 0 clears the screen and writes the
+// score label, then one row of the border each (GRID_HEIGHT of them)
+static uint8_t screen_piece;
+
+// Set once the current frame has had a pass held back for lack of
+// output buffer space, so it is only counted as deferred once
+static uint8_t frame_deferred;
+
+static TerminalViewStats stats;
+
+// Serial output count when the last pass finished. If anything else
+// was printed since, the cursor and colour are no longer known.
+static uint32_t output_count;
+
+static const char tron_line_1[] PROGMEM = "TRON MODE";
+static const char tron_line_2[] PROGMEM = "-----------";
+static const char tron_line_3[] PROGMEM = "CLU: I WILL SHOW YOU NO MERCY, USER!";
+static const char tron_line_4[] PROGMEM = "TRON: DON'T WORRY USER, I FIGHT FOR THE USERS!";
+static PGM_P const tron_lines[TRON_LINES] PROGMEM = {
+	tron_line_1, tron_line_2, tron_line_3, tron_line_4
+};
+
+// top and bottom rows of the border
+static const char border_line[] PROGMEM = "##################";
+_Static_assert(sizeof(border_line) == GRID_WIDTH + 1, "border line doesn't match the grid width");
+
+// Where the terminal cursor is, as far as we know. cursor_x is 0 if
+// we don't know, so the next cell drawn moves the cursor explicitly.
+static uint8_t cursor_x;
+static uint8_t cursor_y;
+
+// Foreground colour the terminal is using, as far as we know, or
+// UNKNOWN_COLOUR so the next coloured cell sets it explicitly.
+#define UNKNOWN_COLOUR 0xFF
+static uint8_t current_colour;
+
+// what a board position should show
+static CellType cell_type(PosnType posn) {
+	if (is_snake_at(posn)) {
+		if (posn == get_snake_head_position()) {
+			return CELL_SNAKE_HEAD;
+		} else if (posn == get_snake_tail_position()) {
+			return CELL_SNAKE_TAIL;
+		}
+		return CELL_SNAKE_BODY;
+	} else if (is_rat_at(posn)) {
+		return CELL_RAT;
+	} else if (is_food_at(posn)) {
+		return CELL_FOOD;
+	} else if (is_super_food_at(posn)) {
+		return CELL_SUPER_FOOD;
+	} else if (is_tron_mode() && is_tron_at(posn)) {
+		if (posn == get_tron_tail_position()) {
+			return CELL_TRON_TAIL;
+		} else if (posn == get_tron_head_position()) {
+			return CELL_TRON_HEAD;
+		}
+		return CELL_TRON_BODY;
+	}
+	return CELL_EMPTY;
+}
+
+// switches the foreground colour, only if it's not already in use.
+// Returns 0 if the change didn't fit in the output buffer.
+static uint8_t use_colour(uint8_t colour) {
+	if (colour != current_colour) {
+		if (!emit_display_attribute(CHANNEL_TERMINAL, colour)) {
+			return 0;
+		}
+		current_colour = colour;
+	}
+	return 1;
+}
+
+// sends a cell to the given terminal position, only moving the cursor
+// if it isn't already there and only changing colour if needed.
+// Returns 0 if the character didn't fit in the output buffer.
+static uint8_t draw_cell(uint8_t x, uint8_t y, CellType type) {
+	char c = pgm_read_byte(&cell_looks[type].c);
+	if (x != cursor_x || y != cursor_y) {
+		if (!emit_move_cursor(CHANNEL_TERMINAL, x, y)) {
+			cursor_x = 0;
+			return 0;
+		}
+		cursor_x = x;
+		cursor_y = y;
+	}
+	// a space looks the same in any colour
+	if (c != ' ' && !use_colour(pgm_read_byte(&cell_looks[type].colour))) {
+		return 0;
+	}
+	if (!emit_char(CHANNEL_TERMINAL, c)) {
+		return 0;
+	}
+	cursor_x = x + 1;
+	cursor_y = y;
+	return 1;
+}
+
+// draws or clears one line of the Tron message
+static void draw_tron_line(uint8_t line, uint8_t on) {
+	emit_move_cursor(CHANNEL_TERMINAL, 1, TRON_TOP + line);
+	if (on) {
+		channel_write_P(CHANNEL_TERMINAL, (PGM_P)pgm_read_word(&tron_lines[line]));
+	} else {
+		emit_clear_to_end_of_line(CHANNEL_TERMINAL);
+	}
+}
+
+// sends the next piece of the screen set up. Each piece is at most 31
+// bytes, so it always fits once step_terminal_view() has checked for
+// TERMINAL_PASS_MAX bytes of space.
+static void step_screen(void) {
+	if (screen_piece == 0) {
+		emit_display_attribute(CHANNEL_TERMINAL, TERM_RESET);
+		emit_clear_terminal(CHANNEL_TERMINAL);
+		emit_hide_cursor(CHANNEL_TERMINAL);
+		emit_display_attribute(CHANNEL_TERMINAL, FG_WHITE);
+		emit_move_cursor(CHANNEL_TERMINAL, SCORE_LEFT, SCORE_TOP);
+		emit_string_P(CHANNEL_TERMINAL, PSTR("Score:"));
+		current_colour = FG_WHITE;
+	} else if (screen_piece == 1 || screen_piece == GRID_HEIGHT) {
+		emit_move_cursor(CHANNEL_TERMINAL, GRID_LEFT, GRID_TOP + screen_piece - 1);
+		emit_string_P(CHANNEL_TERMINAL, border_line);
+	} else {
+		emit_move_cursor(CHANNEL_TERMINAL, GRID_LEFT, GRID_TOP + screen_piece - 1);
+		emit_char(CHANNEL_TERMINAL, '#');
+		emit_move_cursor(CHANNEL_TERMINAL, GRID_LEFT + GRID_WIDTH - 1, GRID_TOP + screen_piece - 1);
+		emit_char(CHANNEL_TERMINAL, '#');
+	}
+	cursor_x = 0;
+	screen_piece++;
+	// the board itself goes out with the next frame
+	if (screen_piece > GRID_HEIGHT) {
+		frame_part = PART_DONE;
+	}
+}
+
+void init_terminal_view(void) {
+	uint8_t x, y;
+	// the terminal will be blank inside the border
+	for (x = 0; x < BOARD_WIDTH; x++) {
+		for (y = 0; y < BOARD_HEIGHT; y++) {
+			last_frame[x][y] = CELL_EMPTY;
+		}
+	}
+	// make sure the score is drawn on the first update
+	last_score = 0xFFFFFFFF;
+	last_tron_mode = 0;
+	last_paused = 0;
+	cursor_x = 0;
+	current_colour = UNKNOWN_COLOUR;
+	frame_part = PART_SCREEN;
+	screen_piece = 0;
+	output_count = get_channel_output_count(CHANNEL_TERMINAL) - 1;
+	stats.frames = 0;
+	stats.dropped = 0;
+	stats.deferred = 0;
+}
+
+void start_terminal_frame(uint8_t paused) {
+	frame_paused = paused;
+	// a frame still in progress just carries on - the cells it has
+	// yet to check will be up to date when it gets to them
+	if (frame_part != PART_DONE) {
+		stats.dropped++;
+		return;
+	}
+	// if the serial link is behind, skip this frame and let the
+	// next one send everything that changed
+	if (channel_space(CHANNEL_TERMINAL) < TERMINAL_FRAME_SPACE) {
+		stats.dropped++;
+		return;
+	}
+	frame_part = PART_CELLS;
+	scan_x = 0;
+	scan_y = 0;
+	frame_deferred = 0;
+	stats.frames++;
+}
+
+void get_terminal_view_stats(TerminalViewStats* view_stats) {
+	*view_stats = stats;
+}
+
+uint8_t is_terminal_view_shown(void) {
+	// telemetry has the serial port to itself unless it is framed
+	return !is_telemetry_on() || are_channels_framed();
+}
+
+uint8_t is_terminal_frame_done(void) {
+	return frame_part == PART_DONE;
+}
+
+uint8_t is_terminal_screen_drawn(void) {
+	// nothing is being drawn while telemetry has the port
+	return frame_part != PART_SCREEN || !is_terminal_view_shown();
+}
+
+// checks the board cells in the current row from scan_x on, sending
+// any that changed until the budget (in bytes sent since start) runs
+// out. Moves on to the next part once the last row is done.
+static void step_cells(uint32_t start) {
+	CellType type;
+	while (scan_x < BOARD_WIDTH && get_channel_output_count(CHANNEL_TERMINAL) - start < TERMINAL_PASS_BUDGET) {
+		type = cell_type(position(scan_x, scan_y));
+		if (type != last_frame[scan_x][scan_y]
+				&& draw_cell(GRID_LEFT + 1 + scan_x, GRID_TOP + BOARD_HEIGHT - scan_y, type)) {
+			last_frame[scan_x][scan_y] = type;
+		}
+		scan_x++;
+	}
+	if (scan_x == BOARD_WIDTH) {
+		scan_x = 0;
+		scan_y++;
+		if (scan_y == BOARD_HEIGHT) {
+			frame_part = PART_SCORE;
+		}
+	}
+}
+
+void step_terminal_view(void) {
+	uint32_t start = get_channel_output_count(CHANNEL_TERMINAL);
+	
+	if (frame_part == PART_DONE) {
+		return;
+	}
+	// never wait on the serial link - try again on a later pass
+	if (channel_space(CHANNEL_TERMINAL) < TERMINAL_PASS_MAX) {
+		if (!frame_deferred) {
+			frame_deferred = 1;
+			stats.deferred++;
+		}
+		return;
+	}
+	// other output may have moved the cursor or changed the colour
+	// since the last pass
+	if (start != output_count) {
+		cursor_x = 0;
+		current_colour = UNKNOWN_COLOUR;
+	}
+	
+	// at most one row of cells or one piece of text per pass
+	switch (frame_part) {
+		case PART_SCREEN:
+			step_screen();
+			break;
+		case PART_CELLS:
+			step_cells(start);
+			break;
+		case PART_SCORE:
+			if (get_score() != last_score) {
+				last_score = get_score();
+				use_colour(FG_WHITE);
+				emit_move_cursor(CHANNEL_TERMINAL, SCORE_VALUE_LEFT, SCORE_TOP);
+				emit_uint(CHANNEL_TERMINAL, last_score, 5);
+				cursor_x = 0;
+			}
+			frame_part = PART_TRON;
+			tron_line = TRON_LINES;
+			if (is_tron_mode() != last_tron_mode) {
+				last_tron_mode = is_tron_mode();
+				tron_line = 0;
+			}
+			break;
+		case PART_TRON:
+			if (tron_line < TRON_LINES) {
+				use_colour(FG_WHITE);
+				draw_tron_line(tron_line, last_tron_mode);
+				cursor_x = 0;
+				tron_line++;
+			}
+			if (tron_line == TRON_LINES) {
+				frame_part = PART_PAUSE;
+			}
+			break;
+		case PART_PAUSE:
+			if (frame_paused != last_paused) {
+				last_paused = frame_paused;
+				use_colour(FG_WHITE);
+				emit_move_cursor(CHANNEL_TERMINAL, 1, PAUSE_TOP);
+				if (last_paused) {
+					emit_string_P(CHANNEL_TERMINAL, PSTR("GAME PAUSE"));
+				} else {
+					emit_clear_to_end_of_line(CHANNEL_TERMINAL);
+				}
+				cursor_x = 0;
+			}
+			frame_part = PART_DONE;
+			break;
+	}
+	output_count = get_channel_output_count(CHANNEL_TERMINAL);
+}
@@ -0,0 +1,102 @@
+/*
+ * terminal_view.h
+ *
+ * Written by Arda Akgur
+ *
+ * Incremental drawing of the game on the serial terminal. The border
+ * and labels are drawn once after init_terminal_view(), a piece per
+ * step_terminal_view() call like the rest of a frame. After that
+ * update_terminal_view() only sends the cells that changed since the
+ * last update (remembered in a copy of the last frame sent), the score
+ * only when it changes and the Tron/pause messages only when they are
+ * turned on or off. Cells are drawn in colour, but the colour escape
+ * code is only sent when it differs from the last one sent.
+ *
+ * A frame is sent a slice at a time so the game never waits on it:
+ * start_terminal_frame() begins a frame and each step_terminal_view()
+ * call sends at most one row of the board (or one piece of text) and
+ * stops early once TERMINAL_PASS_BUDGET bytes have been sent.
+ *
+ * Nothing here waits for the serial link. A pass is put off until
+ * there is room for it in the terminal channel, and a frame is skipped
+ * if the last one hasn't finished or the link is too far behind. The
+ * next frame still sends everything that changed.
+ */
+
+#ifndef TERMINAL_VIEW_H_
+#define TERMINAL_VIEW_H_
+
+#include <stdint.h>
+#include "board.h"
+
+// Start clearing the terminal and drawing the parts of the screen that
+// don't change during a game, then the whole board. Nothing is sent
+// here - step_terminal_view() sends it a piece per pass like a frame,
+// so this can be called mid-game (e.g. after the port changes) without
+// waiting. Call once the game has been initialised.
+void init_terminal_view(void);
+
+// First terminal row below the game, used by the serial console
+#define TERMINAL_CONSOLE_TOP 25
+
+// How often a new frame is started by default, in milliseconds (see
+// TIMING_REFRESH in game.h)
+#define TERMINAL_REFRESH_TIME 180
+
+// Most bytes a frame that redraws every board cell can take: per row a
+// cursor move ("\x1b[rr;ccH") then a colour change ("\x1b[nnm") and
+// character for each cell, plus moving to and printing the score.
+#define TERMINAL_MOVE_BYTES 8
+#define TERMINAL_COLOUR_BYTES 5
+#define TERMINAL_FULL_FRAME_BYTES (BOARD_HEIGHT * (TERMINAL_MOVE_BYTES \
+		+ BOARD_WIDTH * (TERMINAL_COLOUR_BYTES + 1)) \
+		+ TERMINAL_MOVE_BYTES + TERMINAL_COLOUR_BYTES + 5)
+
+// Most bytes step_terminal_view() sends in one call before stopping.
+// One cell costs up to 14 bytes (cursor move, colour, character) and
+// a cell already started is always finished.
+#define TERMINAL_PASS_BUDGET 24
+
+// Most bytes one step_terminal_view() call can send (a line of the
+// Tron message - the screen set up pieces are shorter). A pass is put off until this much space is free in
+// the terminal channel (see channel.h).
+#define TERMINAL_PASS_MAX 64
+
+// Terminal channel space needed to start a frame. Less than this means
+// the serial link is falling behind and the frame is skipped. (The
+// channel holds at most 127 bytes when framing is on.)
+#define TERMINAL_FRAME_SPACE 96
+
+// Frames started, refreshes dropped (skipped or merged into an
+// unfinished frame) and frames that had to wait for buffer space
+typedef struct {
+	uint16_t frames;
+	uint16_t dropped;
+	uint16_t deferred;
+} TerminalViewStats;
+
+// Start bringing the terminal up to date with the game. paused is
+// non-zero while the game is paused. If the last frame hasn't
+// finished it carries on and picks up the latest state as it goes.
+void start_terminal_frame(uint8_t paused);
+
+// Send the next slice of the current frame, if there is one. Call
+// once per pass of the main loop.
+void step_terminal_view(void);
+
+// Returns 1 if the terminal view should be drawn - that is unless
+// telemetry is using the serial port, 0 otherwise.
+uint8_t is_terminal_view_shown(void);
+
+// Returns 1 if the last frame has been completely sent, 0 otherwise.
+uint8_t is_terminal_frame_done(void);
+
+// Returns 0 while the screen set up started by init_terminal_view() is
+// still being sent. Other output to the terminal should wait for it,
+// or the clear would wipe it out.
+uint8_t is_terminal_screen_drawn(void);
+
+// Copy the frame counters since init_terminal_view() into *view_stats.
+void get_terminal_view_stats(TerminalViewStats* view_stats);
+
+#endif /* TERMINAL_VIEW_H_ */
@@ -10,42 +10,108 @@
 #include <avr/pgmspace.h>
 
 #include "terminalio.h"
+#include "emit.h"
+#include "channel.h"
 
+/* Longest sequence built by format_sequence() - ESC [ nnn ; nnn and
+ * the final character.
+ */
+#define SEQUENCE_SIZE 10
+
+/* Build the sequence ESC [ n1 ; n2 final into buffer (leaving out
+ * ";n2" if n2 is negative) and return its length. These are the
+ * sequences sent every frame, so they avoid printf.
+ */
+static uint8_t format_sequence(char* buffer, uint8_t n1, int16_t n2, char final) {
+	uint8_t length = 2;
+	buffer[0] = '\x1b';
+	buffer[1] = '[';
+	length += format_uint(buffer + length, n1, 0);
+	if (n2 >= 0) {
+		buffer[length++] = ';';
+		length += format_uint(buffer + length, n2, 0);
+	}
+	buffer[length++] = final;
+	return length;
+}
+
+/* Send a string from program memory, or a sequence built in buffer
+ * (with room for a terminating 0), to the terminal. They're copied
+ * into the output queue as a block when there's room for them, and
+ * otherwise sent through stdio, which waits for room. Either way they
+ * end up in the same queue as other stdout output, in order.
+ */
+static void send_P(const char* string) {
+	if(!emit_string_P(CHANNEL_TERMINAL, string)) {
+		fputs_P(string, stdout);
+	}
+}
+
+static void send_sequence(char* buffer, uint8_t length) {
+	if(!emit_block(CHANNEL_TERMINAL, buffer, length)) {
+		buffer[length] = 0;
+		fputs(buffer, stdout);
+	}
+}
 
 void move_cursor(int8_t x, int8_t y) {
-    printf_P(PSTR("\x1b[%d;%dH"), y, x);
+	char buffer[SEQUENCE_SIZE + 1];
+	send_sequence(buffer, format_sequence(buffer, y, (uint8_t)x, 'H'));
 }
 
 void normal_display_mode(void) {
-	printf_P(PSTR("\x1b[0m"));
+	send_P(PSTR("\x1b[0m"));
 }
 
 void reverse_video(void) {
-	printf_P(PSTR("\x1b[7m"));
+	send_P(PSTR("\x1b[7m"));
 }
 
 void clear_terminal(void) {
-	printf_P(PSTR("\x1b[2J"));
+	send_P(PSTR("\x1b[2J"));
 }
 
 void clear_to_end_of_line(void) {
-	printf_P(PSTR("\x1b[K"));
+	send_P(PSTR("\x1b[K"));
 }
 
 void set_display_attribute(DisplayParameter parameter) {
-	printf_P(PSTR("\x1b[%dm"), parameter);
+	char buffer[SEQUENCE_SIZE + 1];
+	send_sequence(buffer, format_sequence(buffer, parameter, -1, 'm'));
+}
+
+uint8_t emit_move_cursor(uint8_t channel, int8_t x, int8_t y) {
+	char buffer[SEQUENCE_SIZE];
+	return emit_block(channel, buffer, format_sequence(buffer, y, (uint8_t)x, 'H'));
+}
+
+uint8_t emit_display_attribute(uint8_t channel, DisplayParameter parameter) {
+	char buffer[SEQUENCE_SIZE];
+	return emit_block(channel, buffer, format_sequence(buffer, parameter, -1, 'm'));
+}
+
+uint8_t emit_clear_to_end_of_line(uint8_t channel) {
+	return emit_string_P(channel, PSTR("\x1b[K"));
+}
+
+uint8_t emit_clear_terminal(uint8_t channel) {
+	return emit_string_P(channel, PSTR("\x1b[2J"));
+}
+
+uint8_t emit_hide_cursor(uint8_t channel) {
+	return emit_string_P(channel, PSTR("\x1b[?25l"));
 }
 
 void hide_cursor() {
-	printf_P(PSTR("\x1b[?25l"));
+	send_P(PSTR("\x1b[?25l"));
 }
 
 void show_cursor() {
-	printf_P(PSTR("\x1b[?25h"));
+	send_P(PSTR("\x1b[?25h"));
 }
 
 void enable_scrolling_for_whole_display(void) {
-	printf_P(PSTR("\x1b[r"));
+	send_P(PSTR("\x1b[r"));
 }
 
 void set_scroll_region(int8_t y1, int8_t y2) {
@@ -53,11 +119,11 @@ void set_scroll_region(int8_t y1, int8_t y2) {
 }
 
 void scroll_down(void) {
-	printf_P(PSTR("\x1bM"));	// ESC-M
+	send_P(PSTR("\x1bM"));	// ESC-M
 }
 
 void scroll_up(void) {
-	printf_P(PSTR("\x1b\x44"));	// ESC-D
+	send_P(PSTR("\x1b\x44"));	// ESC-D
 }
 
 void draw_horizontal_line(int8_t y, int8_t start_x, int8_t end_x) {
@@ -80,7 +146,7 @@ void draw_vertical_line(int8_t x, int8_t start_y, int8_t end_y) {
 	for(i=start_y; i < end_y; i++) {
 		printf(" ");
 		/* Move down one and back to the left one */
-		printf_P(PSTR("\x1b[B\x1b[D"));
+		send_P(PSTR("\x1b[B\x1b[D"));
 	}
 	printf(" ");
 	normal_display_mode();
@@ -63,6 +63,17 @@ void set_display_attribute(DisplayParameter parameter);
 void hide_cursor(void);
 void show_cursor(void);
 
+/*
+ * Versions of the above that write to a channel (see channel.h) without
+ * waiting, for the terminal view which redraws a little at a time.
+ * Each returns 1 if the whole sequence was queued, 0 if none of it was.
+ */
+uint8_t emit_move_cursor(uint8_t channel, int8_t x, int8_t y);
+uint8_t emit_display_attribute(uint8_t channel, DisplayParameter parameter);
+uint8_t emit_clear_to_end_of_line(uint8_t channel);
+uint8_t emit_clear_terminal(uint8_t channel);
+uint8_t emit_hide_cursor(uint8_t channel);
+
 // Enable scrolling for either the full screen or a particular region (rows)
 // For set_scroll_region y1 < y2 and the region includes rows y1 and y2.
 void enable_scrolling_for_whole_display(void);
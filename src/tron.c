@@ -26,6 +26,7 @@
 #include "timer0.h"
 #include "superFood.h"
 #include "rat.h"
+#include "state_hash.h"
 
 //using same inistance variables of snake.c
 #define SNAKE_POSITION_ARRAY_SIZE ((MAX_SNAKE_SIZE)+1)
@@ -117,8 +118,14 @@ uint8_t is_tron_mode(void) {
 	return tron_mode;
 }
 
-// change tron mode
+// change tron mode, the tron only counts in the state hash while on
 void set_tron_mode(uint8_t mode) {
+	uint8_t i;
+	if (mode != tron_mode) {
+		for (i = 0; i < snakeLength; i++) {
+			toggle_state_hash(HASH_TRON, get_tron_position(i));
+		}
+	}
 	tron_mode = mode;
 }
 
@@ -158,6 +165,33 @@ uint8_t get_tron_length(void) {
 	return snakeLength;
 }
 
+// returns the position index places from the tail of the tron
+PosnType get_tron_position(uint8_t index) {
+	return snakePositions[(snakeTailIndex + index) % SNAKE_POSITION_ARRAY_SIZE];
+}
+
+// returns the current direction of the tron
+SnakeDirnType get_tron_dirn(void) {
+	return curSnakeDirn;
+}
+
+// starts rebuilding a saved tron from its tail, see restore_snake()
+void restore_tron(PosnType tail, SnakeDirnType dirn) {
+	snakeLength = 1;
+	snakeTailIndex = 0;
+	snakeHeadIndex = 0;
+	snakePositions[0] = tail;
+	curSnakeDirn = dirn;
+	nextSnakeDirn = dirn;
+}
+
+// adds a new head position to a tron being rebuilt
+void extend_tron(PosnType posn) {
+	snakeHeadIndex++;
+	snakePositions[snakeHeadIndex] = posn;
+	snakeLength++;
+}
+
 /* advance_tron_head()
 **
 ** Attempt to move snake head forward. Returns
@@ -262,6 +296,7 @@ int8_t advance_tron_head(void) {
 	}
 	/* Store the head position */
 	snakePositions[snakeHeadIndex] = newHeadPosn;
+	toggle_state_hash(HASH_TRON, newHeadPosn);
 	/* Update the snake's length */
 	snakeLength++;
 	
@@ -306,6 +341,7 @@ int8_t advance_tron_head(void) {
 PosnType advance_tron_tail(void) {
 	// Get the current tail position
 	PosnType prev_tail_position = snakePositions[snakeTailIndex];
+	toggle_state_hash(HASH_TRON, prev_tail_position);
 	
 	/* Update the tail index */
 	snakeTailIndex++;
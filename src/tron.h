@@ -15,6 +15,10 @@ void init_tron(void);
 PosnType get_tron_head_position(void);
 PosnType get_tron_tail_position(void);
 uint8_t get_tron_length(void);
+PosnType get_tron_position(uint8_t index);
+SnakeDirnType get_tron_dirn(void);
+void restore_tron(PosnType tail, SnakeDirnType dirn);
+void extend_tron(PosnType posn);
 int8_t advance_tron_head();
 PosnType advance_tron_tail();
 void set_tron_dirn(SnakeDirnType dirn);
@@ -0,0 +1,268 @@
+/*
+ * chansplit.c
+ *
+ * Written by Arda Akgur
+ *
+ * Splits the framed serial stream from the game (see src/channel.h)
+ * back into its channels. The terminal channel goes to stdout, so the
+ * game can be watched as usual, while log and RPC output go elsewhere.
+ *
+ * Usage: chansplit [-b baud] [-x] [-i] [-p] [-c command] [-t file] [-l file] [-r file]
+ *                  [file|device]
+ *   -b baud  set up the serial port (any rate on Linux, e.g. 250000;
+ *            elsewhere 19200, 38400 or 57600)
+ *   -x       send 'x' first, to turn framing on (needs a device)
+ *   -i       interactive - send keys typed as terminal channel
+ *            frames, Ctrl-] to quit (needs a device)
+ *   -p       send an RPC "ping" request (needs a device)
+ *   -c cmd   send a console command as an RPC request, e.g. "stats"
+ *            (needs a device)
+ *   -t file  write the telemetry channel to file (for telview)
+ *   -l file  write log lines to file (default stderr)
+ *   -r file  write RPC responses to file (default stderr)
+ * Per-channel counts are printed to stderr at the end.
+ */
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "cobs.h"
+#include "serial_speed.h"
+
+// Must match src/channel.h
+enum {CHANNEL_TERMINAL, CHANNEL_TELEMETRY, CHANNEL_LOG, CHANNEL_RPC, NUM_CHANNELS};
+#define FRAME_PAYLOAD 32
+
+static const char* const channel_names[NUM_CHANNELS] = {
+	"terminal", "telemetry", "log", "rpc"
+};
+
+typedef struct {
+	FILE* out;
+	const char* prefix;	// put at the start of each line, or NULL
+	int at_line_start;
+	unsigned long frames;
+	unsigned long bytes;
+} ChannelOut;
+
+static ChannelOut channels[NUM_CHANNELS];
+static unsigned long bad_frames;
+
+static void usage(void) {
+	fprintf(stderr, "usage: chansplit [-b baud] [-x] [-i] [-p] [-c command] "
+			"[-t file] [-l file] [-r file] [file|device]\n");
+	exit(2);
+}
+
+static FILE* open_output(const char* filename) {
+	FILE* f = fopen(filename, "wb");
+	if (!f) {
+		perror(filename);
+		exit(1);
+	}
+	return f;
+}
+
+// raw 8N1 at the given rate
+static int setup_serial(int fd, long baud) {
+	struct termios tio;
+	if (tcgetattr(fd, &tio) != 0) {
+		return -1;
+	}
+	cfmakeraw(&tio);
+	tio.c_cflag |= CLOCAL | CREAD;
+	if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+		return -1;
+	}
+	return set_serial_speed(fd, baud);
+}
+
+// sends data to the game as one frame on the given channel
+static void send_frame(int fd, int channel, const uint8_t* data, size_t length) {
+	uint8_t frame[FRAME_PAYLOAD + 1];
+	uint8_t encoded[COBS_MAX_ENCODED(FRAME_PAYLOAD + 1) + 1];
+	size_t n;
+	frame[0] = (uint8_t)(channel + 1);
+	memcpy(frame + 1, data, length);
+	n = cobs_encode(frame, length + 1, encoded);
+	encoded[n++] = 0;
+	if (write(fd, encoded, n) != (ssize_t)n) {
+		perror("chansplit: write");
+	}
+}
+
+static void deliver(const uint8_t* frame, long length) {
+	ChannelOut* ch;
+	long i;
+	if (length < 1 || frame[0] < 1 || frame[0] > NUM_CHANNELS) {
+		bad_frames++;
+		return;
+	}
+	ch = &channels[frame[0] - 1];
+	ch->frames++;
+	ch->bytes += length - 1;
+	for (i = 1; i < length; i++) {
+		if (ch->prefix && ch->at_line_start) {
+			fputs(ch->prefix, ch->out);
+		}
+		fputc(frame[i], ch->out);
+		ch->at_line_start = ch->prefix && frame[i] == '\n';
+	}
+	fflush(ch->out);
+}
+
+int main(int argc, char** argv) {
+	uint8_t buffer[256];
+	uint8_t encoded[COBS_MAX_ENCODED(FRAME_PAYLOAD + 1) + 1];
+	uint8_t frame[sizeof(encoded)];
+	size_t encoded_length = 0;
+	int overflow = 0;
+	long baud = 0;
+	int send_x = 0, interactive = 0;
+	const char* command = NULL;
+	const char* telemetry_file = NULL;
+	const char* log_file = NULL;
+	const char* rpc_file = NULL;
+	const char* device = NULL;
+	int fd = 0;
+	struct termios saved_tio;
+	struct pollfd fds[2];
+	ssize_t n, j;
+	int i;
+
+	for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+		if (!strcmp(argv[i], "-x")) {
+			send_x = 1;
+		} else if (!strcmp(argv[i], "-i")) {
+			interactive = 1;
+		} else if (!strcmp(argv[i], "-p")) {
+			command = "ping";
+		} else if (i + 1 < argc && !strcmp(argv[i], "-c")) {
+			command = argv[++i];
+		} else if (i + 1 < argc && !strcmp(argv[i], "-b")) {
+			baud = strtol(argv[++i], NULL, 0);
+		} else if (i + 1 < argc && !strcmp(argv[i], "-t")) {
+			telemetry_file = argv[++i];
+		} else if (i + 1 < argc && !strcmp(argv[i], "-l")) {
+			log_file = argv[++i];
+		} else if (i + 1 < argc && !strcmp(argv[i], "-r")) {
+			rpc_file = argv[++i];
+		} else {
+			usage();
+		}
+	}
+	if (i < argc - 1) {
+		usage();
+	}
+	if (i == argc - 1 && strcmp(argv[i], "-")) {
+		device = argv[i];
+		fd = open(device, (send_x || interactive || command ? O_RDWR : O_RDONLY) | O_NOCTTY);
+		if (fd < 0) {
+			perror(device);
+			return 1;
+		}
+	}
+	if ((send_x || interactive || command) && !device) {
+		usage();
+	}
+	if (baud && setup_serial(fd, baud) != 0) {
+		perror("chansplit: serial setup");
+		return 1;
+	}
+
+	channels[CHANNEL_TERMINAL].out = stdout;
+	channels[CHANNEL_TELEMETRY].out = telemetry_file ? open_output(telemetry_file) : NULL;
+	channels[CHANNEL_LOG].out = log_file ? open_output(log_file) : stderr;
+	channels[CHANNEL_LOG].prefix = log_file ? NULL : "[log] ";
+	channels[CHANNEL_RPC].out = rpc_file ? open_output(rpc_file) : stderr;
+	channels[CHANNEL_RPC].prefix = rpc_file ? NULL : "[rpc] ";
+	for (i = 0; i < NUM_CHANNELS; i++) {
+		channels[i].at_line_start = 1;
+	}
+	if (!channels[CHANNEL_TELEMETRY].out) {
+		channels[CHANNEL_TELEMETRY].out = fopen("/dev/null", "wb");
+	}
+
+	if (send_x && write(fd, "x", 1) != 1) {
+		perror("chansplit: write");
+	}
+	if (command) {
+		// request id 1, then the command line
+		uint8_t request[FRAME_PAYLOAD];
+		size_t length = strlen(command);
+		if (length > FRAME_PAYLOAD - 1) {
+			length = FRAME_PAYLOAD - 1;
+		}
+		request[0] = 1;
+		memcpy(request + 1, command, length);
+		send_frame(fd, CHANNEL_RPC, request, length + 1);
+	}
+	if (interactive) {
+		struct termios tio;
+		tcgetattr(0, &saved_tio);
+		tio = saved_tio;
+		cfmakeraw(&tio);
+		tcsetattr(0, TCSANOW, &tio);
+	}
+
+	fds[0].fd = fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = 0;
+	fds[1].events = POLLIN;
+	while (poll(fds, interactive ? 2 : 1, -1) > 0) {
+		if (interactive && (fds[1].revents & POLLIN)) {
+			n = read(0, buffer, sizeof(buffer));
+			if (n <= 0 || memchr(buffer, 0x1D, n)) {
+				break;
+			}
+			for (j = 0; j < n; j += FRAME_PAYLOAD) {
+				send_frame(fd, CHANNEL_TERMINAL, buffer + j,
+						n - j < FRAME_PAYLOAD ? n - j : FRAME_PAYLOAD);
+			}
+		}
+		if (!(fds[0].revents & (POLLIN | POLLHUP))) {
+			continue;
+		}
+		n = read(fd, buffer, sizeof(buffer));
+		if (n <= 0) {
+			break;
+		}
+		for (j = 0; j < n; j++) {
+			if (buffer[j] != 0) {
+				if (encoded_length < sizeof(encoded)) {
+					encoded[encoded_length++] = buffer[j];
+				} else {
+					overflow = 1;
+				}
+				continue;
+			}
+			// end of a frame - an empty one is just a lone delimiter,
+			// e.g. from starting part way through
+			if (encoded_length || overflow) {
+				long length = overflow ? -1 : cobs_decode(encoded, encoded_length, frame);
+				if (length < 0) {
+					bad_frames++;
+				} else {
+					deliver(frame, length);
+				}
+			}
+			encoded_length = 0;
+			overflow = 0;
+		}
+	}
+
+	if (interactive) {
+		tcsetattr(0, TCSANOW, &saved_tio);
+	}
+	for (i = 0; i < NUM_CHANNELS; i++) {
+		fprintf(stderr, "%s: %lu frames, %lu bytes\n", channel_names[i],
+				channels[i].frames, channels[i].bytes);
+	}
+	fprintf(stderr, "bad frames: %lu\n", bad_frames);
+	return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * cobs.c
+ *
+ * Written by Arda Akgur
+ */
+
+#include "cobs.h"
+
+size_t cobs_encode(const uint8_t* data, size_t length, uint8_t* out) {
+	size_t code_at = 0;	// where the current block's code goes
+	size_t n = 1;
+	uint8_t code = 1;
+	size_t i;
+	for (i = 0; i < length; i++) {
+		if (data[i] == 0) {
+			out[code_at] = code;
+			code_at = n++;
+			code = 1;
+		} else {
+			out[n++] = data[i];
+			code++;
+			if (code == 0xFF) {
+				out[code_at] = code;
+				code_at = n++;
+				code = 1;
+			}
+		}
+	}
+	out[code_at] = code;
+	return n;
+}
+
+long cobs_decode(const uint8_t* data, size_t length, uint8_t* out) {
+	size_t i = 0;
+	size_t n = 0;
+	uint8_t code, j;
+	while (i < length) {
+		code = data[i++];
+		if (code == 0 || i + code - 1 > length) {
+			return -1;
+		}
+		for (j = 1; j < code; j++) {
+			if (data[i] == 0) {
+				return -1;
+			}
+			out[n++] = data[i++];
+		}
+		// a block shorter than the maximum ends in a 0, unless it's
+		// the last one
+		if (code != 0xFF && i < length) {
+			out[n++] = 0;
+		}
+	}
+	return (long)n;
+}
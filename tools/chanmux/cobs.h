@@ -0,0 +1,30 @@
+/*
+ * cobs.h
+ *
+ * Written by Arda Akgur
+ *
+ * Consistent Overhead Byte Stuffing, as used for the serial channel
+ * frames (see src/channel.h). Encoding removes every 0 byte from the
+ * data at a cost of one byte per 254, so 0 can mark the end of a
+ * frame.
+ */
+
+#ifndef COBS_H_
+#define COBS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Encoded size is at most COBS_MAX_ENCODED(n) for n bytes of data
+// (not counting the 0 that ends a frame).
+#define COBS_MAX_ENCODED(n) ((n) + (n) / 254 + 1)
+
+// Encode length bytes of data into out. Returns the encoded length.
+size_t cobs_encode(const uint8_t* data, size_t length, uint8_t* out);
+
+// Decode length bytes (not including the frame's ending 0) into out,
+// which must hold length bytes. Returns the decoded length, or -1 if
+// the data isn't valid COBS.
+long cobs_decode(const uint8_t* data, size_t length, uint8_t* out);
+
+#endif /* COBS_H_ */
@@ -0,0 +1,63 @@
+/*
+ * serial_speed.c
+ *
+ * Written by Arda Akgur
+ *
+ * On Linux any rate can be asked for with termios2 and BOTHER, which
+ * the USB serial adapters we use accept. <asm/termbits.h> clashes with
+ * <termios.h>, which is why this lives in a file of its own. Elsewhere
+ * only the rates with a Bxxx constant can be set.
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include "serial_speed.h"
+
+#ifdef __linux__
+
+#include <sys/ioctl.h>
+#include <asm/termbits.h>
+
+int set_serial_speed(int fd, long baud) {
+	struct termios2 tio;
+	if (baud <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (ioctl(fd, TCGETS2, &tio) != 0) {
+		return -1;
+	}
+	tio.c_cflag &= ~CBAUD;
+	tio.c_cflag |= BOTHER;
+	tio.c_ispeed = (speed_t)baud;
+	tio.c_ospeed = (speed_t)baud;
+	return ioctl(fd, TCSETS2, &tio);
+}
+
+#else
+
+#include <termios.h>
+
+int set_serial_speed(int fd, long baud) {
+	struct termios tio;
+	speed_t speed;
+	switch (baud) {
+		case 19200: speed = B19200; break;
+		case 38400: speed = B38400; break;
+		case 57600: speed = B57600; break;
+#ifdef B76800
+		case 76800: speed = B76800; break;
+#endif
+		default:
+			errno = EINVAL;
+			return -1;
+	}
+	if (tcgetattr(fd, &tio) != 0) {
+		return -1;
+	}
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	return tcsetattr(fd, TCSANOW, &tio);
+}
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * serial_speed.h
+ *
+ * Written by Arda Akgur
+ *
+ * Sets the baud rate of a serial port, including the rates the game
+ * offers that have no Bxxx constant (76800, 125000 and 250000, see
+ * src/baud.h). Shared by chansplit and ../telemetry/telview.
+ */
+
+#ifndef SERIAL_SPEED_H_
+#define SERIAL_SPEED_H_
+
+// Sets both directions of the serial port fd to baud. The rest of the
+// port set up (raw mode and so on) is left alone. Returns 0, or -1 with
+// errno set - EINVAL if the rate can't be set on this system.
+int set_serial_speed(int fd, long baud);
+
+#endif /* SERIAL_SPEED_H_ */
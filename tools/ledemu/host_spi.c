@@ -0,0 +1,32 @@
+/*
+ * host_spi.c
+ *
+ * Written by Arda Akgur
+ *
+ * Host replacement for spi.c. Every byte the firmware would send
+ * over SPI is fed to an LED matrix emulator instead, so modules such
+ * as ledmatrix.c can be compiled and run on a PC unchanged.
+ */
+
+#include <stdint.h>
+#include "../../src/spi.h"
+#include "ledemu.h"
+#include "host_spi.h"
+
+static LedEmulator* target;
+
+void host_spi_attach(LedEmulator* emu) {
+	target = emu;
+}
+
+void spi_setup_master(uint8_t clockdivider) {
+	(void)clockdivider;
+}
+
+uint8_t spi_send_byte(uint8_t byte) {
+	if (target) {
+		ledemu_feed(target, byte);
+	}
+	// the matrix never sends anything back
+	return 0;
+}
@@ -0,0 +1,18 @@
+/*
+ * host_spi.h
+ *
+ * Written by Arda Akgur
+ *
+ * Connects the host replacement for spi.c to an LED matrix emulator.
+ */
+
+#ifndef HOST_SPI_H_
+#define HOST_SPI_H_
+
+#include "ledemu.h"
+
+// Send all following spi_send_byte() calls to the given emulator
+// (or discard them if emu is NULL).
+void host_spi_attach(LedEmulator* emu);
+
+#endif /* HOST_SPI_H_ */
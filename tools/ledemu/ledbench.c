@@ -0,0 +1,102 @@
+/*
+ * ledbench.c
+ *
+ * Written by Arda Akgur
+ *
+ * Runs the firmware's ledmatrix.c on the host against the emulator and
+ * reports the SPI traffic of common display operations. The resulting
+ * framebuffer is checked against the expected picture after each
+ * operation so protocol regressions show up as a failure (exit status 1).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../../src/ledmatrix.h"
+#include "ledemu.h"
+#include "host_spi.h"
+
+static LedEmulator emu;
+static MatrixData expected;
+static int failures;
+
+// colour used for the test pattern at x, y
+static PixelColour pattern(uint8_t x, uint8_t y) {
+	return (PixelColour)(((x + y) & 0x0F) | (((x * 3 + y) & 0x0F) << 4));
+}
+
+static void report(const char* name) {
+	LedEmuStats stats;
+	ledemu_end_frame(&emu, &stats);
+	printf("%-28s ", name);
+	ledemu_print_stats(&stats, stdout);
+	if (memcmp(emu.pixels, expected, sizeof(expected)) != 0 || stats.bad_bytes) {
+		printf("  FAILED: framebuffer does not match\n");
+		failures++;
+	}
+}
+
+int main(void) {
+	uint8_t x, y;
+	MatrixRow row;
+	MatrixColumn col;
+
+	ledemu_init(&emu);
+	host_spi_attach(&emu);
+	ledmatrix_setup();
+
+	ledmatrix_clear();
+	memset(expected, 0, sizeof(expected));
+	report("clear");
+
+	for (y = 0; y < MATRIX_NUM_ROWS; y++) {
+		for (x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			expected[x][y] = pattern(x, y);
+			ledmatrix_update_pixel(x, y, pattern(x, y));
+		}
+	}
+	report("full redraw by pixel");
+
+	for (x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		for (y = 0; y < MATRIX_NUM_ROWS; y++) {
+			expected[x][y] = pattern(y, x);
+		}
+	}
+	ledmatrix_update_all(expected);
+	report("full redraw by update_all");
+
+	for (y = 0; y < MATRIX_NUM_ROWS; y++) {
+		for (x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+			row[x] = expected[x][y] = pattern(x, y);
+		}
+		ledmatrix_update_row(y, row);
+	}
+	report("full redraw by row");
+
+	// same pattern as the scrolling text: shift left, new column at 15
+	for (x = 0; x < MATRIX_NUM_COLUMNS; x++) {
+		uint8_t i;
+		for (i = 0; i < MATRIX_NUM_COLUMNS - 1; i++) {
+			copy_matrix_column(expected[i + 1], expected[i]);
+		}
+		for (y = 0; y < MATRIX_NUM_ROWS; y++) {
+			col[y] = pattern(x, 7 - y);
+		}
+		copy_matrix_column(col, expected[MATRIX_NUM_COLUMNS - 1]);
+		ledmatrix_shift_display_left();
+		ledmatrix_update_column(MATRIX_NUM_COLUMNS - 1, col);
+	}
+	report("scroll 16 columns");
+
+	// a snake move: tail cleared, old head to body, new head drawn
+	expected[3][1] = COLOUR_BLACK;
+	expected[5][1] = COLOUR_GREEN;
+	expected[6][1] = COLOUR_RED;
+	ledmatrix_update_pixel(3, 1, COLOUR_BLACK);
+	ledmatrix_update_pixel(5, 1, COLOUR_GREEN);
+	ledmatrix_update_pixel(6, 1, COLOUR_RED);
+	report("snake move");
+
+	printf("total: ");
+	ledemu_print_stats(&emu.total, stdout);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * ledemu.c
+ *
+ * Written by Arda Akgur
+ *
+ * Decoder for the LED matrix SPI protocol. Bytes are fed in one at a
+ * time, exactly as the board would receive them, so partial commands
+ * spanning several calls are handled.
+ */
+
+#include <string.h>
+#include "ledemu.h"
+
+// number of bytes following the command byte, indexed by LedEmuCommand
+static const uint8_t argument_bytes[LEDEMU_NUM_COMMANDS] = {
+	LEDEMU_COLUMNS * LEDEMU_ROWS,	// update all
+	2,				// pixel: position, colour
+	1 + LEDEMU_COLUMNS,		// row: row number, colours
+	1 + LEDEMU_ROWS,		// column: column number, colours
+	1,				// shift: direction
+	0				// clear
+};
+
+static int command_index(uint8_t command) {
+	switch (command) {
+		case LEDEMU_CMD_UPDATE_ALL: return LEDEMU_ALL;
+		case LEDEMU_CMD_UPDATE_PIXEL: return LEDEMU_PIXEL;
+		case LEDEMU_CMD_UPDATE_ROW: return LEDEMU_ROW;
+		case LEDEMU_CMD_UPDATE_COL: return LEDEMU_COL;
+		case LEDEMU_CMD_SHIFT_DISPLAY: return LEDEMU_SHIFT;
+		case LEDEMU_CMD_CLEAR_SCREEN: return LEDEMU_CLEAR;
+	}
+	return -1;
+}
+
+static void shift_display(LedEmulator* emu, uint8_t direction) {
+	uint8_t x, y;
+	if (direction & 0x02) {
+		// left: column x takes column x+1, rightmost column cleared
+		for (x = 0; x < LEDEMU_COLUMNS - 1; x++) {
+			memcpy(emu->pixels[x], emu->pixels[x + 1], LEDEMU_ROWS);
+		}
+		memset(emu->pixels[LEDEMU_COLUMNS - 1], 0, LEDEMU_ROWS);
+	}
+	if (direction & 0x01) {
+		// right
+		for (x = LEDEMU_COLUMNS - 1; x > 0; x--) {
+			memcpy(emu->pixels[x], emu->pixels[x - 1], LEDEMU_ROWS);
+		}
+		memset(emu->pixels[0], 0, LEDEMU_ROWS);
+	}
+	if (direction & 0x08) {
+		// up: y = 7 is the top row
+		for (x = 0; x < LEDEMU_COLUMNS; x++) {
+			for (y = LEDEMU_ROWS - 1; y > 0; y--) {
+				emu->pixels[x][y] = emu->pixels[x][y - 1];
+			}
+			emu->pixels[x][0] = 0;
+		}
+	}
+	if (direction & 0x04) {
+		// down
+		for (x = 0; x < LEDEMU_COLUMNS; x++) {
+			for (y = 0; y < LEDEMU_ROWS - 1; y++) {
+				emu->pixels[x][y] = emu->pixels[x][y + 1];
+			}
+			emu->pixels[x][LEDEMU_ROWS - 1] = 0;
+		}
+	}
+}
+
+// apply a fully received command to the framebuffer
+static void execute(LedEmulator* emu) {
+	uint8_t* args = emu->args;
+	uint8_t x, y;
+	switch (emu->command) {
+		case LEDEMU_CMD_UPDATE_ALL:
+			for (y = 0; y < LEDEMU_ROWS; y++) {
+				for (x = 0; x < LEDEMU_COLUMNS; x++) {
+					emu->pixels[x][y] = args[y * LEDEMU_COLUMNS + x];
+				}
+			}
+			break;
+		case LEDEMU_CMD_UPDATE_PIXEL:
+			emu->pixels[args[0] & 0x0F][(args[0] >> 4) & 0x07] = args[1];
+			break;
+		case LEDEMU_CMD_UPDATE_ROW:
+			for (x = 0; x < LEDEMU_COLUMNS; x++) {
+				emu->pixels[x][args[0] & 0x07] = args[1 + x];
+			}
+			break;
+		case LEDEMU_CMD_UPDATE_COL:
+			for (y = 0; y < LEDEMU_ROWS; y++) {
+				emu->pixels[args[0] & 0x0F][y] = args[1 + y];
+			}
+			break;
+		case LEDEMU_CMD_SHIFT_DISPLAY:
+			shift_display(emu, args[0]);
+			break;
+		case LEDEMU_CMD_CLEAR_SCREEN:
+			memset(emu->pixels, 0, sizeof(emu->pixels));
+			break;
+	}
+}
+
+void ledemu_init(LedEmulator* emu) {
+	memset(emu, 0, sizeof(*emu));
+}
+
+void ledemu_feed(LedEmulator* emu, uint8_t byte) {
+	emu->frame.bytes++;
+	emu->total.bytes++;
+	if (emu->expected) {
+		// argument byte of the current command
+		emu->args[emu->received++] = byte;
+		emu->expected--;
+	} else {
+		int index = command_index(byte);
+		if (index < 0) {
+			emu->frame.bad_bytes++;
+			emu->total.bad_bytes++;
+			return;
+		}
+		emu->frame.commands++;
+		emu->total.commands++;
+		emu->frame.per_command[index]++;
+		emu->total.per_command[index]++;
+		emu->command = byte;
+		emu->expected = argument_bytes[index];
+		emu->received = 0;
+	}
+	if (!emu->expected) {
+		execute(emu);
+	}
+}
+
+void ledemu_end_frame(LedEmulator* emu, LedEmuStats* frame_stats) {
+	if (frame_stats) {
+		*frame_stats = emu->frame;
+	}
+	memset(&emu->frame, 0, sizeof(emu->frame));
+	emu->frames++;
+}
+
+int ledemu_in_command(const LedEmulator* emu) {
+	return emu->expected != 0;
+}
+
+void ledemu_print(const LedEmulator* emu, FILE* out, int colour) {
+	int x, y;
+	// y = 7 is the top row of the matrix
+	for (y = LEDEMU_ROWS - 1; y >= 0; y--) {
+		for (x = 0; x < LEDEMU_COLUMNS; x++) {
+			uint8_t pixel = emu->pixels[x][y];
+			uint8_t red = pixel & 0x0F;
+			uint8_t green = pixel >> 4;
+			if (colour) {
+				fprintf(out, "\x1b[48;2;%d;%d;0m  ", red * 17, green * 17);
+			} else if (red && green) {
+				fputc('y', out);
+			} else if (red) {
+				fputc('r', out);
+			} else if (green) {
+				fputc('g', out);
+			} else {
+				fputc('.', out);
+			}
+		}
+		if (colour) {
+			fputs("\x1b[0m", out);
+		}
+		fputc('\n', out);
+	}
+}
+
+int ledemu_write_ppm(const LedEmulator* emu, const char* filename, int scale) {
+	FILE* out = fopen(filename, "wb");
+	int x, y, row, col;
+	if (!out) {
+		return -1;
+	}
+	fprintf(out, "P6\n%d %d\n255\n", LEDEMU_COLUMNS * scale, LEDEMU_ROWS * scale);
+	for (y = LEDEMU_ROWS - 1; y >= 0; y--) {
+		for (row = 0; row < scale; row++) {
+			for (x = 0; x < LEDEMU_COLUMNS; x++) {
+				uint8_t pixel = emu->pixels[x][y];
+				for (col = 0; col < scale; col++) {
+					fputc((pixel & 0x0F) * 17, out);
+					fputc((pixel >> 4) * 17, out);
+					fputc(0, out);
+				}
+			}
+		}
+	}
+	return fclose(out) == 0 ? 0 : -1;
+}
+
+void ledemu_print_stats(const LedEmuStats* stats, FILE* out) {
+	fprintf(out, "bytes %lu commands %lu (all %lu pixel %lu row %lu col %lu "
+			"shift %lu clear %lu) bad %lu\n",
+			(unsigned long)stats->bytes, (unsigned long)stats->commands,
+			(unsigned long)stats->per_command[LEDEMU_ALL],
+			(unsigned long)stats->per_command[LEDEMU_PIXEL],
+			(unsigned long)stats->per_command[LEDEMU_ROW],
+			(unsigned long)stats->per_command[LEDEMU_COL],
+			(unsigned long)stats->per_command[LEDEMU_SHIFT],
+			(unsigned long)stats->per_command[LEDEMU_CLEAR],
+			(unsigned long)stats->bad_bytes);
+}
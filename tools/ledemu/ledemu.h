@@ -0,0 +1,82 @@
+/*
+ * ledemu.h
+ *
+ * Written by Arda Akgur
+ *
+ * Host-side emulator for the LED matrix board. It decodes the same
+ * byte stream that spi_send_byte() sends from ledmatrix.c, keeps the
+ * 16x8 framebuffer and counts the bytes and commands seen since the
+ * last frame boundary. Builds with any C99 compiler - it has no AVR
+ * dependencies.
+ */
+
+#ifndef LEDEMU_H_
+#define LEDEMU_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define LEDEMU_COLUMNS 16
+#define LEDEMU_ROWS 8
+
+// Commands understood by the matrix (see ledmatrix.c)
+#define LEDEMU_CMD_UPDATE_ALL 0x00
+#define LEDEMU_CMD_UPDATE_PIXEL 0x01
+#define LEDEMU_CMD_UPDATE_ROW 0x02
+#define LEDEMU_CMD_UPDATE_COL 0x03
+#define LEDEMU_CMD_SHIFT_DISPLAY 0x04
+#define LEDEMU_CMD_CLEAR_SCREEN 0x0F
+
+// Index of each command in the per-command counters
+typedef enum {
+	LEDEMU_ALL, LEDEMU_PIXEL, LEDEMU_ROW, LEDEMU_COL,
+	LEDEMU_SHIFT, LEDEMU_CLEAR, LEDEMU_NUM_COMMANDS
+} LedEmuCommand;
+
+typedef struct {
+	uint32_t bytes;
+	uint32_t commands;
+	uint32_t per_command[LEDEMU_NUM_COMMANDS];
+	uint32_t bad_bytes;	// bytes that didn't start a known command
+} LedEmuStats;
+
+typedef struct {
+	// pixels[x][y], same layout as MatrixData. Colour is 4 bits of
+	// green in the high nibble and 4 bits of red in the low nibble.
+	uint8_t pixels[LEDEMU_COLUMNS][LEDEMU_ROWS];
+	LedEmuStats frame;	// since the last ledemu_end_frame()
+	LedEmuStats total;	// since ledemu_init()
+	uint32_t frames;
+	// decoder state for a partially received command
+	uint8_t command;
+	uint8_t expected;	// bytes of the command still to come
+	uint8_t received;	// argument bytes received so far
+	uint8_t args[LEDEMU_COLUMNS * LEDEMU_ROWS + 1];
+} LedEmulator;
+
+// Reset the emulator: blank display, zero counters, no partial command.
+void ledemu_init(LedEmulator* emu);
+
+// Feed one byte from the SPI stream.
+void ledemu_feed(LedEmulator* emu, uint8_t byte);
+
+// Mark a frame boundary. The per-frame counters are returned in
+// *frame_stats (if not NULL) and then cleared.
+void ledemu_end_frame(LedEmulator* emu, LedEmuStats* frame_stats);
+
+// Returns 1 if a command has been started but not completed.
+int ledemu_in_command(const LedEmulator* emu);
+
+// Print the framebuffer to the given stream. If colour is non-zero,
+// 24-bit ANSI colour escape sequences are used, otherwise each pixel
+// is a character: '.' off, 'r' red, 'g' green, 'y' both.
+void ledemu_print(const LedEmulator* emu, FILE* out, int colour);
+
+// Write the framebuffer as a binary PPM, each pixel scaled to a
+// scale x scale block. Returns 0 on success, -1 on error.
+int ledemu_write_ppm(const LedEmulator* emu, const char* filename, int scale);
+
+// Print a one-line summary of the given counters.
+void ledemu_print_stats(const LedEmuStats* stats, FILE* out);
+
+#endif /* LEDEMU_H_ */
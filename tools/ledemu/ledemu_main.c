@@ -0,0 +1,115 @@
+/*
+ * ledemu_main.c
+ *
+ * Written by Arda Akgur
+ *
+ * Command line front end for the LED matrix emulator. Reads a raw SPI
+ * byte stream (as captured from the MOSI line, or as produced by the
+ * host build of the firmware) and replays it into the emulator.
+ *
+ * Usage: ledemu [-b bytes] [-k commands] [-t] [-c] [-p prefix] [-s scale] [file]
+ *   -b n       end a frame every n bytes
+ *   -k n       end a frame every n commands
+ *   -t         print each frame to the terminal
+ *   -c         use colour when printing (implies -t)
+ *   -p prefix  write each frame to prefix0000.ppm, prefix0001.ppm, ...
+ *   -s n       PPM scale factor (default 16)
+ * With neither -b nor -k the whole stream is one frame. Per-frame
+ * and total byte/command counts are always printed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ledemu.h"
+
+static void usage(void) {
+	fprintf(stderr, "usage: ledemu [-b bytes] [-k commands] [-t] [-c] "
+			"[-p prefix] [-s scale] [file]\n");
+	exit(2);
+}
+
+static void finish_frame(LedEmulator* emu, int print, int colour,
+		const char* prefix, int scale) {
+	LedEmuStats stats;
+	uint32_t number = emu->frames;
+	ledemu_end_frame(emu, &stats);
+	printf("frame %lu: ", (unsigned long)number);
+	ledemu_print_stats(&stats, stdout);
+	if (print) {
+		ledemu_print(emu, stdout, colour);
+	}
+	if (prefix) {
+		char filename[1024];
+		snprintf(filename, sizeof(filename), "%s%04lu.ppm", prefix, (unsigned long)number);
+		if (ledemu_write_ppm(emu, filename, scale) != 0) {
+			perror(filename);
+			exit(1);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	LedEmulator emu;
+	unsigned long frame_bytes = 0;
+	unsigned long frame_commands = 0;
+	int print = 0;
+	int colour = 0;
+	int scale = 16;
+	const char* prefix = NULL;
+	FILE* in = stdin;
+	int i, c;
+
+	for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+		if (!strcmp(argv[i], "-t")) {
+			print = 1;
+		} else if (!strcmp(argv[i], "-c")) {
+			print = colour = 1;
+		} else if (i + 1 < argc && !strcmp(argv[i], "-b")) {
+			frame_bytes = strtoul(argv[++i], NULL, 0);
+		} else if (i + 1 < argc && !strcmp(argv[i], "-k")) {
+			frame_commands = strtoul(argv[++i], NULL, 0);
+		} else if (i + 1 < argc && !strcmp(argv[i], "-p")) {
+			prefix = argv[++i];
+		} else if (i + 1 < argc && !strcmp(argv[i], "-s")) {
+			scale = atoi(argv[++i]);
+			if (scale < 1) {
+				usage();
+			}
+		} else {
+			usage();
+		}
+	}
+	if (i < argc - 1) {
+		usage();
+	}
+	if (i == argc - 1 && strcmp(argv[i], "-")) {
+		in = fopen(argv[i], "rb");
+		if (!in) {
+			perror(argv[i]);
+			return 1;
+		}
+	}
+
+	ledemu_init(&emu);
+	while ((c = fgetc(in)) != EOF) {
+		ledemu_feed(&emu, (uint8_t)c);
+		// only split frames between commands
+		if (ledemu_in_command(&emu)) {
+			continue;
+		}
+		if ((frame_bytes && emu.frame.bytes >= frame_bytes) ||
+				(frame_commands && emu.frame.commands >= frame_commands)) {
+			finish_frame(&emu, print, colour, prefix, scale);
+		}
+	}
+	if (emu.frame.bytes || emu.frames == 0) {
+		finish_frame(&emu, print, colour, prefix, scale);
+	}
+	if (ledemu_in_command(&emu)) {
+		fprintf(stderr, "warning: stream ended part way through a command\n");
+	}
+	printf("total (%lu frames): ", (unsigned long)emu.frames);
+	ledemu_print_stats(&emu.total, stdout);
+	return 0;
+}
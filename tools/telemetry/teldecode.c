@@ -0,0 +1,263 @@
+/*
+ * teldecode.c
+ *
+ * Written by Arda Akgur
+ *
+ * Telemetry packet decoder. A packet's length isn't known until its
+ * type (and for keyframes and deltas, its item count) has arrived, so
+ * packet_length() is asked again after each byte. If a packet turns
+ * out to be bad, the sync byte that started it is skipped and the
+ * rest is fed through again, in case a real packet started inside it.
+ */
+
+#include <string.h>
+#include "teldecode.h"
+
+#define KEYFRAME_FIXED (3 + TELDEC_COLUMNS + 7)
+#define DELTA_FIXED (3 + 5)
+
+uint8_t teldec_crc8(uint8_t crc, uint8_t data) {
+	int i;
+	crc ^= data;
+	for (i = 0; i < 8; i++) {
+		crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+	}
+	return crc;
+}
+
+// Bytes in the whole packet (CRC included) given what's arrived so
+// far, 0 if not known yet or -1 if it can't be a packet.
+static int packet_length(const TelDecoder* dec) {
+	const uint8_t* p = dec->packet;
+	if (dec->length < 2) {
+		return 0;
+	}
+	switch (p[1]) {
+		case TELDEC_KEYFRAME:
+			if (dec->length < KEYFRAME_FIXED) {
+				return 0;
+			}
+			if (p[KEYFRAME_FIXED - 1] > TELDEC_MAX_FOOD) {
+				return -1;
+			}
+			return KEYFRAME_FIXED + p[KEYFRAME_FIXED - 1] + 1;
+		case TELDEC_DELTA:
+			if (dec->length < DELTA_FIXED) {
+				return 0;
+			}
+			if (DELTA_FIXED + 2 * p[DELTA_FIXED - 1] + 1 > TELDEC_MAX_PACKET) {
+				return -1;
+			}
+			return DELTA_FIXED + 2 * p[DELTA_FIXED - 1] + 1;
+		case TELDEC_GAME_OVER:
+			return 3 + 2 + 1;
+		default:
+			return -1;
+	}
+}
+
+static void set_bit(uint8_t* bitmap, uint8_t posn, int on) {
+	uint8_t x = posn >> 4;
+	uint8_t y = posn & 0x0F;
+	if (y >= TELDEC_ROWS) {
+		return;
+	}
+	if (on) {
+		bitmap[x] |= 1 << y;
+	} else {
+		bitmap[x] &= ~(1 << y);
+	}
+}
+
+static void apply_keyframe(TelDecoder* dec) {
+	const uint8_t* p = dec->packet + 3;
+	int i;
+	memcpy(dec->snake, p, TELDEC_COLUMNS);
+	p += TELDEC_COLUMNS;
+	dec->head = p[0];
+	dec->tail = p[1];
+	dec->rat = p[2];
+	dec->super_food = p[3];
+	dec->score = p[4] | (p[5] << 8);
+	memset(dec->food, 0, sizeof(dec->food));
+	for (i = 0; i < p[6]; i++) {
+		set_bit(dec->food, p[7 + i], 1);
+	}
+	dec->synced = 1;
+	dec->game_over = 0;
+}
+
+static void apply_delta(TelDecoder* dec) {
+	const uint8_t* p = dec->packet + 3;
+	int i;
+	if (p[1] != dec->tail) {
+		set_bit(dec->snake, dec->tail, 0);
+	}
+	set_bit(dec->snake, p[0], 1);
+	dec->head = p[0];
+	dec->tail = p[1];
+	dec->score = p[2] | (p[3] << 8);
+	for (i = 0; i < p[4]; i++) {
+		uint8_t kind = p[5 + 2 * i];
+		uint8_t posn = p[6 + 2 * i];
+		switch (kind) {
+			case TELDEC_FOOD_ADDED:
+				set_bit(dec->food, posn, 1);
+				break;
+			case TELDEC_FOOD_REMOVED:
+				set_bit(dec->food, posn, 0);
+				break;
+			case TELDEC_RAT_MOVED:
+				dec->rat = posn;
+				break;
+			case TELDEC_SUPER_FOOD_MOVED:
+				dec->super_food = posn;
+				break;
+		}
+	}
+}
+
+// Deals with a complete packet of the given length. Returns its type,
+// or 0 if the CRC is wrong.
+static int finish_packet(TelDecoder* dec, int length) {
+	const uint8_t* p = dec->packet;
+	uint8_t crc = 0;
+	int i;
+	for (i = 1; i < length - 1; i++) {
+		crc = teldec_crc8(crc, p[i]);
+	}
+	if (crc != p[length - 1]) {
+		dec->stats.crc_errors++;
+		return 0;
+	}
+	if (dec->stats.packets && p[2] != (uint8_t)(dec->sequence + 1)) {
+		dec->stats.gaps += (uint8_t)(p[2] - dec->sequence - 1);
+		dec->synced = 0;
+	}
+	dec->sequence = p[2];
+	dec->stats.packets++;
+	switch (p[1]) {
+		case TELDEC_KEYFRAME:
+			dec->stats.keyframes++;
+			apply_keyframe(dec);
+			break;
+		case TELDEC_DELTA:
+			dec->stats.deltas++;
+			// a delta is no use without the board it applies to
+			if (dec->synced) {
+				apply_delta(dec);
+			}
+			break;
+		case TELDEC_GAME_OVER:
+			dec->score = p[3] | (p[4] << 8);
+			dec->game_over = 1;
+			break;
+	}
+	return p[1];
+}
+
+void teldec_init(TelDecoder* dec) {
+	memset(dec, 0, sizeof(*dec));
+	dec->head = dec->tail = dec->rat = dec->super_food = TELDEC_NO_POSITION;
+}
+
+// Adds a byte to the packet being received without counting it
+static int add_byte(TelDecoder* dec, uint8_t byte) {
+	uint8_t rest[TELDEC_MAX_PACKET];
+	int length, i, n, type;
+
+	if (dec->length == 0) {
+		if (byte != TELDEC_SYNC) {
+			dec->stats.skipped++;
+			return 0;
+		}
+	}
+	dec->packet[dec->length++] = byte;
+	length = packet_length(dec);
+	if (length == 0 || (length > 0 && dec->length < length)) {
+		return 0;
+	}
+	if (length > 0) {
+		type = finish_packet(dec, length);
+		if (type) {
+			dec->length = 0;
+			return type;
+		}
+	}
+	// not a packet - skip the sync byte and look again at the rest
+	n = dec->length - 1;
+	memcpy(rest, dec->packet + 1, n);
+	dec->length = 0;
+	dec->stats.skipped++;
+	type = 0;
+	for (i = 0; i < n; i++) {
+		int t = add_byte(dec, rest[i]);
+		if (t) {
+			type = t;
+		}
+	}
+	return type;
+}
+
+int teldec_feed(TelDecoder* dec, uint8_t byte) {
+	dec->stats.bytes++;
+	return add_byte(dec, byte);
+}
+
+void teldec_print(const TelDecoder* dec, FILE* out, int colour) {
+	int x, y;
+	fprintf(out, "Score: %5u  %-22s\n", dec->score,
+			dec->game_over ? "GAME OVER" : dec->synced ? "" : "(waiting for keyframe)");
+	for (x = 0; x < TELDEC_COLUMNS + 2; x++) {
+		fputc('#', out);
+	}
+	fputc('\n', out);
+	for (y = TELDEC_ROWS - 1; y >= 0; y--) {
+		fputc('#', out);
+		for (x = 0; x < TELDEC_COLUMNS; x++) {
+			uint8_t posn = (uint8_t)((x << 4) | y);
+			const char* ansi = "";
+			char c = ' ';
+			if (posn == dec->head) {
+				c = 'H';
+				ansi = "\x1b[34m";
+			} else if (posn == dec->tail) {
+				c = 'T';
+				ansi = "\x1b[34m";
+			} else if ((dec->snake[x] >> y) & 1) {
+				c = '#';
+				ansi = "\x1b[35m";
+			} else if (posn == dec->rat) {
+				c = 'r';
+				ansi = "\x1b[32m";
+			} else if ((dec->food[x] >> y) & 1) {
+				c = 'f';
+				ansi = "\x1b[37m";
+			} else if (posn == dec->super_food) {
+				c = 's';
+				ansi = "\x1b[31m";
+			}
+			if (colour && c != ' ') {
+				fprintf(out, "%s%c\x1b[0m", ansi, c);
+			} else {
+				fputc(c, out);
+			}
+		}
+		fputs("#\n", out);
+	}
+	for (x = 0; x < TELDEC_COLUMNS + 2; x++) {
+		fputc('#', out);
+	}
+	fputc('\n', out);
+}
+
+void teldec_print_stats(const TelDecStats* stats, FILE* out) {
+	fprintf(out, "%lu bytes, %lu packets (%lu keyframes, %lu deltas), "
+			"%lu CRC errors, %lu missed, %lu skipped",
+			stats->bytes, stats->packets, stats->keyframes, stats->deltas,
+			stats->crc_errors, stats->gaps, stats->skipped);
+	if (stats->packets) {
+		fprintf(out, ", %.1f bytes/packet", (double)(stats->bytes - stats->skipped) / stats->packets);
+	}
+	fputc('\n', out);
+}
@@ -0,0 +1,78 @@
+/*
+ * teldecode.h
+ *
+ * Written by Arda Akgur
+ *
+ * Host-side decoder for the binary telemetry stream sent by
+ * src/telemetry.c (see telemetry.h there for the packet layout). Bytes
+ * are fed one at a time; complete packets with a good CRC are applied
+ * to a copy of the board. Anything else in the stream (terminal text,
+ * damaged packets) is skipped. Builds with any C99 compiler.
+ */
+
+#ifndef TELDECODE_H_
+#define TELDECODE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define TELDEC_COLUMNS 16
+#define TELDEC_ROWS 8
+
+// Must match src/telemetry.h
+#define TELDEC_SYNC 0x7E
+#define TELDEC_KEYFRAME 'K'
+#define TELDEC_DELTA 'D'
+#define TELDEC_GAME_OVER 'X'
+#define TELDEC_FOOD_ADDED 1
+#define TELDEC_FOOD_REMOVED 2
+#define TELDEC_RAT_MOVED 3
+#define TELDEC_SUPER_FOOD_MOVED 4
+#define TELDEC_NO_POSITION 0x08
+#define TELDEC_MAX_FOOD 8
+#define TELDEC_MAX_PACKET (3 + TELDEC_COLUMNS + 7 + TELDEC_MAX_FOOD + 1)
+
+typedef struct {
+	unsigned long bytes;
+	unsigned long packets;
+	unsigned long keyframes;
+	unsigned long deltas;
+	unsigned long crc_errors;
+	unsigned long gaps;		// packets missed (by sequence number)
+	unsigned long skipped;	// bytes that weren't part of a packet
+} TelDecStats;
+
+typedef struct {
+	// board as last received, bitmaps indexed [x] with bit y
+	uint8_t snake[TELDEC_COLUMNS];
+	uint8_t food[TELDEC_COLUMNS];
+	uint8_t head, tail, rat, super_food;
+	uint16_t score;
+	int synced;		// a keyframe has arrived and nothing was missed since
+	int game_over;
+	uint8_t sequence;	// of the last packet
+	TelDecStats stats;
+	// packet being received
+	uint8_t packet[TELDEC_MAX_PACKET];
+	int length;
+} TelDecoder;
+
+// Reset the decoder: empty board, not synced, zero counters.
+void teldec_init(TelDecoder* dec);
+
+// Feed one byte of the stream. Returns the packet type when it
+// completes a good packet, 0 otherwise.
+int teldec_feed(TelDecoder* dec, uint8_t byte);
+
+// Print the board, score and sync state. Uses ANSI colours if colour
+// is non-zero.
+void teldec_print(const TelDecoder* dec, FILE* out, int colour);
+
+// Print the counters on one line.
+void teldec_print_stats(const TelDecStats* stats, FILE* out);
+
+// CRC-8 as used by the packets - the same as avr-libc's
+// _crc8_ccitt_update().
+uint8_t teldec_crc8(uint8_t crc, uint8_t data);
+
+#endif /* TELDECODE_H_ */
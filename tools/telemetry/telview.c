@@ -0,0 +1,109 @@
+/*
+ * telview.c
+ *
+ * Written by Arda Akgur
+ *
+ * Shows the game from its binary telemetry stream. Reads the stream
+ * from a file, stdin or a serial port and redraws the board after
+ * every keyframe and delta, so it keeps up with the game at any speed.
+ *
+ * Usage: telview [-b baud] [-c] [-n] [file|device]
+ *   -b baud  set up the serial port (any rate on Linux, e.g. 250000;
+ *            elsewhere 19200, 38400 or 57600)
+ *   -c       use colour
+ *   -n       don't draw the board, just print a line per packet
+ * Counters are printed when the stream ends.
+ */
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "teldecode.h"
+#include "../chanmux/serial_speed.h"
+
+static void usage(void) {
+	fprintf(stderr, "usage: telview [-b baud] [-c] [-n] [file|device]\n");
+	exit(2);
+}
+
+// raw 8N1 at the given rate
+static int setup_serial(int fd, long baud) {
+	struct termios tio;
+	if (tcgetattr(fd, &tio) != 0) {
+		return -1;
+	}
+	cfmakeraw(&tio);
+	tio.c_cflag |= CLOCAL | CREAD;
+	if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+		return -1;
+	}
+	return set_serial_speed(fd, baud);
+}
+
+int main(int argc, char** argv) {
+	TelDecoder dec;
+	long baud = 0;
+	int colour = 0;
+	int draw = 1;
+	int fd = 0;
+	int cleared = 0;
+	int i, type;
+	ssize_t n, j;
+	uint8_t buffer[256];
+
+	for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++) {
+		if (!strcmp(argv[i], "-c")) {
+			colour = 1;
+		} else if (!strcmp(argv[i], "-n")) {
+			draw = 0;
+		} else if (i + 1 < argc && !strcmp(argv[i], "-b")) {
+			baud = strtol(argv[++i], NULL, 0);
+		} else {
+			usage();
+		}
+	}
+	if (i < argc - 1) {
+		usage();
+	}
+	if (i == argc - 1 && strcmp(argv[i], "-")) {
+		fd = open(argv[i], O_RDONLY | O_NOCTTY);
+		if (fd < 0) {
+			perror(argv[i]);
+			return 1;
+		}
+	}
+	if (baud && setup_serial(fd, baud) != 0) {
+		perror("telview: serial setup");
+		return 1;
+	}
+
+	teldec_init(&dec);
+	while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+		for (j = 0; j < n; j++) {
+			type = teldec_feed(&dec, buffer[j]);
+			if (!type) {
+				continue;
+			}
+			if (!draw) {
+				printf("%3u %c score %u%s\n", dec.sequence, type, dec.score,
+						dec.synced ? "" : " (not synced)");
+			} else if (type != TELDEC_DELTA || dec.synced) {
+				// clear the screen once, then draw over the last board
+				if (!cleared) {
+					fputs("\x1b[2J", stdout);
+					cleared = 1;
+				}
+				fputs("\x1b[H", stdout);
+				teldec_print(&dec, stdout, colour);
+				teldec_print_stats(&dec.stats, stdout);
+			}
+			fflush(stdout);
+		}
+	}
+	teldec_print_stats(&dec.stats, stdout);
+	return 0;
+}